@@ -0,0 +1,559 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "random.h"
+#include "fkin.h"
+#include "geometry.h"
+#include "trajectory.h"
+#include "evaluator.h"
+#include "evolution.h"
+#include "utils.h"
+#include "pool.h"
+
+const char *HELP_MESSAGE = "Usage: ./bin/bench [options]                                                    \n"
+                           "                                                                                \n"
+                           "The bench program measures the hot path of the evaluation: fkin, the stride,    \n"
+                           "the fitness and its gradient, the segment intersection test, the selection of   \n"
+                           "the survivors, and whole generations. Every benchmark is repeated until it has  \n"
+                           "run for the minimum time, and reports the time per operation and the number of  \n"
+                           "items (crank configurations, segment pairs, linkages or individuals) processed  \n"
+                           "per second.                                                                     \n"
+                           "                                                                                \n"
+                           "Before benchmarking, the fitness screened by the batch kernels is checked       \n"
+                           "against the long double reference on random linkages at a low resolution, and   \n"
+                           "the program fails if they disagree.                                             \n"
+                           "                                                                                \n"
+                           "Options:                                                                        \n"
+                           "    --trajectory <path>: The target trajectory (default trajectory.txt).        \n"
+                           "    --min-time <seconds>: The minimum time of every benchmark (default 0.5).    \n"
+                           "    --filter <name>: Only run the benchmarks whose name contains this string.   \n"
+                           "    --threads <num_threads>: The number of threads of the generation benchmarks \n"
+                           "        (default 1).                                                            \n"
+                           "    --json <path>: Also write the results to this file as JSON lines, one object\n"
+                           "        per benchmark, to compare against other builds.                         \n";
+
+/** The number of segment pairs that the intersection benchmark cycles through */
+#define NUM_SEGMENT_PAIRS 1024
+
+/**
+ * @brief A benchmark, which runs its operation a number of times
+ *
+ * @param context The data of the benchmark
+ * @param iterations The number of operations to run
+ */
+typedef void (*bench_function)(void *context, size_t iterations);
+
+/**
+ * @struct bench_settings
+ * @brief The settings shared by every benchmark.
+ *
+ * @param min_time The minimum time of every benchmark, in seconds.
+ * @param filter Only the benchmarks whose name contains this string run, or NULL.
+ * @param json The file that the results are also written to, or NULL.
+ */
+typedef struct bench_settings {
+    double min_time;
+    const char *filter;
+    FILE *json;
+} bench_settings;
+
+/** The stride resolution of the check, low enough for linkages to break between samples */
+#define CHECK_RESOLUTION 6
+
+/** The number of unbroken linkages that the screened fitness is checked on */
+#define CHECK_LINKAGES 2000
+
+/** Keeps the compiler from optimizing the benchmarked work away */
+static volatile decimal sink;
+
+/**
+ * @brief Gets the wall time elapsed since a start time, in seconds
+ */
+static double get_elapsed_seconds(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Checks the screened fitness against the reference fitness
+ *
+ * At a low resolution, many linkages only break at the crank angle of a
+ * waypoint, between the sampled angles, which the batch kernels must
+ * handle like the reference does. A screened linkage may still break where
+ * the reference does not, but if it does not break, its fitness must be
+ * close to the reference.
+ *
+ * @param target_stride The target trajectory
+ * @return true if every screened fitness agrees with the reference
+ */
+static bool check_screened_fitness(trajectory *target_stride) {
+    const precision precisions[] = {PRECISION_FLOAT, PRECISION_DOUBLE};
+    const char *precision_names[] = {"float", "double"};
+    const decimal tolerances[] = {1e-3, 1e-9};
+    const fkin_backend backends[] = {FKIN_TRIGONOMETRIC, FKIN_ALGEBRAIC};
+    const char *backend_names[] = {"trig", "algebraic"};
+    bool agreed = true;
+
+    for (size_t i = 0; i < sizeof(precisions) / sizeof(precisions[0]); i++) {
+        for (size_t j = 0; j < sizeof(backends) / sizeof(backends[0]); j++) {
+            evaluator *eval = evaluator_init(target_stride, CHECK_RESOLUTION, backends[j], precisions[i], 0, 0, 0, false, 1);
+            rng generator;
+            rng_seed(&generator, 1, 0);
+            size_t num_checked = 0;
+            size_t num_disagreements = 0;
+
+            while (num_checked < CHECK_LINKAGES) {
+                linkage link;
+                rnd_fill(&generator, link.lengths, NUM_LINKS);
+                decimal reference = compute_reference_fitness(link, eval);
+
+                if (reference == -INFINITY) {
+                    continue;
+                }
+
+                decimal screened = compute_fitness(link, eval);
+                num_checked++;
+
+                if (screened != -INFINITY && !(abs(screened - reference) <= tolerances[i] * (1 + abs(reference)))) {
+                    num_disagreements++;
+                }
+            }
+
+            char variant[64];
+            snprintf(variant, sizeof(variant), "res=%d,fkin=%s,%s", CHECK_RESOLUTION, backend_names[j], precision_names[i]);
+            printf("%-20s %-28s %12zu of %zu linkages disagree\n", "check_fitness", variant, num_disagreements, num_checked);
+            agreed = agreed && num_disagreements == 0;
+            evaluator_free(eval);
+        }
+    }
+
+    fflush(stdout);
+
+    return agreed;
+}
+
+/**
+ * @brief Checks whether a benchmark is selected by the filter
+ */
+static bool bench_selected(const bench_settings *settings, const char *name) {
+    return settings->filter == NULL || strstr(name, settings->filter) != NULL;
+}
+
+/**
+ * @brief Runs a benchmark and reports its speed
+ *
+ * The number of iterations grows until a run lasts the minimum time, and
+ * the last run is reported, so that the earlier runs also warm up the
+ * caches.
+ *
+ * @param settings The settings shared by every benchmark
+ * @param name The name of the benchmark
+ * @param variant The parameters of the benchmark
+ * @param unit The items that the benchmark processes
+ * @param items_per_op The number of items processed by a single operation
+ * @param function The benchmark
+ * @param context The data of the benchmark
+ */
+static void bench_run(const bench_settings *settings,
+                      const char *name,
+                      const char *variant,
+                      const char *unit,
+                      double items_per_op,
+                      bench_function function,
+                      void *context) {
+    if (!bench_selected(settings, name)) {
+        return;
+    }
+
+    size_t iterations = 1;
+    double seconds;
+
+    while (true) {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        function(context, iterations);
+        seconds = get_elapsed_seconds(&start);
+
+        if (seconds >= settings->min_time) {
+            break;
+        }
+
+        // Aim past the minimum time, but do not grow too fast on a noisy run
+        double growth = seconds > 0 ? 1.4 * settings->min_time / seconds : 100;
+        growth = growth < 2 ? 2 : growth > 100 ? 100 : growth;
+        iterations = iterations * growth;
+    }
+
+    double ns_per_op = 1e9 * seconds / iterations;
+    double items_per_second = items_per_op * iterations / seconds;
+
+    printf("%-20s %-28s %12zu iterations %14.1f ns/op %14.4g %s/s\n", name, variant, iterations, ns_per_op, items_per_second, unit);
+    fflush(stdout);
+
+    if (settings->json != NULL) {
+        fprintf(settings->json,
+                "{\"name\": \"%s\", \"variant\": \"%s\", \"unit\": \"%s\", \"iterations\": %zu, \"ns_per_op\": %.3f, \"items_per_second\": %.6g}\n",
+                name, variant, unit, iterations, ns_per_op, items_per_second);
+    }
+}
+
+/**
+ * @struct fkin_context
+ * @brief Solves Jansen's linkage at a fixed crank angle.
+ */
+typedef struct fkin_context {
+    decimal theta;
+} fkin_context;
+
+static void bench_fkin(void *context, size_t iterations) {
+    fkin_context *ctx = context;
+    decimal total = 0;
+
+    for (size_t i = 0; i < iterations; i++) {
+        skeleton skel = fkin(JANSENS_LINKAGE, ctx->theta);
+        total += skel.joints[NUM_JOINTS - 1].y;
+    }
+
+    sink = total;
+}
+
+/**
+ * @struct stride_context
+ * @brief Solves a whole stride of Jansen's linkage.
+ */
+typedef struct stride_context {
+    crank_table *crank;
+    fkin_backend backend;
+    path *stride;
+} stride_context;
+
+static void bench_compute_stride(void *context, size_t iterations) {
+    stride_context *ctx = context;
+    decimal total = 0;
+
+    for (size_t i = 0; i < iterations; i++) {
+        compute_stride(JANSENS_LINKAGE, ctx->crank, ctx->backend, ctx->stride);
+        total += ctx->stride->points[0].y;
+    }
+
+    sink = total;
+}
+
+/**
+ * @struct fitness_context
+ * @brief Computes the fitness of Jansen's linkage against the target.
+ */
+typedef struct fitness_context {
+    evaluator *eval;
+} fitness_context;
+
+static void bench_compute_fitness(void *context, size_t iterations) {
+    fitness_context *ctx = context;
+    decimal total = 0;
+
+    for (size_t i = 0; i < iterations; i++) {
+        total += compute_fitness(JANSENS_LINKAGE, ctx->eval);
+    }
+
+    sink = total;
+}
+
+static void bench_compute_fitness_gradient(void *context, size_t iterations) {
+    fitness_context *ctx = context;
+    decimal total = 0;
+    decimal gradient[NUM_LINKS];
+
+    for (size_t i = 0; i < iterations; i++) {
+        total += compute_fitness_gradient(JANSENS_LINKAGE, ctx->eval, gradient) + gradient[0];
+    }
+
+    sink = total;
+}
+
+/**
+ * @struct intersect_context
+ * @brief Tests random pairs of segments for intersection.
+ */
+typedef struct intersect_context {
+    segment first[NUM_SEGMENT_PAIRS];
+    segment second[NUM_SEGMENT_PAIRS];
+} intersect_context;
+
+static void bench_segments_intersect(void *context, size_t iterations) {
+    intersect_context *ctx = context;
+    size_t count = 0;
+
+    for (size_t i = 0; i < iterations; i++) {
+        size_t pair = i % NUM_SEGMENT_PAIRS;
+        count += segments_intersect(ctx->first[pair], ctx->second[pair]);
+    }
+
+    sink = count;
+}
+
+/**
+ * @struct selection_context
+ * @brief Selects the survivors of a population with random fitnesses.
+ */
+typedef struct selection_context {
+    population *pop;
+    size_t num_survivors;
+    bool deterministic;
+    rng generator;
+    generation_buffers *buffers;
+} selection_context;
+
+static void bench_select_survivors(void *context, size_t iterations) {
+    selection_context *ctx = context;
+    decimal total = 0;
+
+    for (size_t i = 0; i < iterations; i++) {
+        population *survivors = select_survivors(ctx->pop, ctx->num_survivors, ctx->deterministic, &ctx->generator, ctx->buffers);
+        total += survivors->fitness[0];
+    }
+
+    sink = total;
+}
+
+/**
+ * @struct generation_context
+ * @brief Evolves a population one generation at a time.
+ */
+typedef struct generation_context {
+    population *pop;
+    evaluator *eval;
+    size_t num_survivors;
+    replacement_policy replacement;
+    rng generator;
+    size_t num_children;
+    thread_pool *pool;
+    generation_buffers *buffers;
+} generation_context;
+
+static void bench_evolve_population(void *context, size_t iterations) {
+    generation_context *ctx = context;
+
+    if (ctx->replacement == REPLACEMENT_GENERATIONAL) {
+        for (size_t i = 0; i < iterations; i++) {
+            evolve_population(ctx->pop, ctx->eval, ctx->num_survivors, 0.5, 0, 0.01, false, true, true, &ctx->generator, ctx->pool, ctx->buffers);
+        }
+    } else {
+        // The steady state breeds the generations in a single stream, as runs do
+        size_t num_offspring = ctx->pop->size - ctx->num_survivors;
+        evolve_population_steady_state(ctx->pop, ctx->eval, iterations * num_offspring, 0.5, 0, 0.01, false, ctx->replacement, true, 3, ctx->num_children, ctx->pool, ctx->buffers);
+        ctx->num_children += iterations * num_offspring;
+    }
+
+    sink = ctx->pop->fitness[0];
+}
+
+int main(int argc, char *argv[]) {
+    if (argc % 2 != 1) {
+        fprintf(stderr, "%s", HELP_MESSAGE);
+        return 1;
+    }
+
+    const char *trajectory_path = "trajectory.txt";
+    const char *json_path = NULL;
+    size_t num_threads = 1;
+    bench_settings settings = {
+        .min_time = 0.5,
+        .filter = NULL,
+        .json = NULL,
+    };
+
+    for (int i = 1; i < argc; i += 2) {
+        const char *option = argv[i];
+        const char *value = argv[i + 1];
+
+        if (strcmp(option, "--trajectory") == 0) {
+            trajectory_path = value;
+        } else if (strcmp(option, "--min-time") == 0) {
+            settings.min_time = atof(value);
+        } else if (strcmp(option, "--filter") == 0) {
+            settings.filter = value;
+        } else if (strcmp(option, "--threads") == 0) {
+            num_threads = atoi(value);
+        } else if (strcmp(option, "--json") == 0) {
+            json_path = value;
+        } else {
+            fprintf(stderr, "Error: Unknown option %s\n", option);
+            fprintf(stderr, "%s", HELP_MESSAGE);
+            return 1;
+        }
+    }
+
+    if (num_threads < 1) {
+        fprintf(stderr, "Error: The number of threads must be at least 1\n");
+        return 1;
+    }
+
+    if (json_path != NULL) {
+        settings.json = fopen(json_path, "w");
+
+        if (settings.json == NULL) {
+            fprintf(stderr, "Error: Could not open file %s\n", json_path);
+            return 1;
+        }
+    }
+
+    trajectory *target_stride = trajectory_read(trajectory_path);
+    char variant[64];
+
+    if (!check_screened_fitness(target_stride)) {
+        fprintf(stderr, "Error: The screened fitness disagrees with the reference fitness\n");
+        return 1;
+    }
+
+    // fkin at fixed crank angles
+    const decimal angles[] = {0, M_PI / 2, M_PI, 3 * M_PI / 2};
+
+    for (size_t i = 0; i < sizeof(angles) / sizeof(angles[0]); i++) {
+        fkin_context ctx = {.theta = angles[i]};
+        snprintf(variant, sizeof(variant), "theta=%.4f", (double)angles[i]);
+        bench_run(&settings, "fkin", variant, "configs", 1, bench_fkin, &ctx);
+    }
+
+    // compute_stride across resolutions and kernels
+    const size_t resolutions[] = {64, 256, 1024};
+    const fkin_backend backends[] = {FKIN_TRIGONOMETRIC, FKIN_ALGEBRAIC};
+    const char *backend_names[] = {"trig", "algebraic"};
+
+    for (size_t i = 0; i < sizeof(resolutions) / sizeof(resolutions[0]); i++) {
+        for (size_t j = 0; j < sizeof(backends) / sizeof(backends[0]); j++) {
+            stride_context ctx = {
+                .crank = crank_table_uniform(resolutions[i]),
+                .backend = backends[j],
+                .stride = path_init(resolutions[i]),
+            };
+            snprintf(variant, sizeof(variant), "res=%zu,fkin=%s", resolutions[i], backend_names[j]);
+            bench_run(&settings, "compute_stride", variant, "configs", resolutions[i], bench_compute_stride, &ctx);
+            free(ctx.crank);
+            free(ctx.stride);
+        }
+    }
+
+    // compute_fitness on the target trajectory, without the cache
+    const precision precisions[] = {PRECISION_FLOAT, PRECISION_DOUBLE, PRECISION_LONG_DOUBLE};
+    const char *precision_names[] = {"float", "double", "long"};
+
+    for (size_t i = 0; i < sizeof(precisions) / sizeof(precisions[0]); i++) {
+        for (size_t j = 0; j < sizeof(backends) / sizeof(backends[0]); j++) {
+            if (!bench_selected(&settings, "compute_fitness")) {
+                continue;
+            }
+
+            fitness_context ctx = {.eval = evaluator_init(target_stride, 256, backends[j], precisions[i], 0, 0, 0, false, 1)};
+            snprintf(variant, sizeof(variant), "res=256,fkin=%s,%s", backend_names[j], precision_names[i]);
+            bench_run(&settings, "compute_fitness", variant, "linkages", 1, bench_compute_fitness, &ctx);
+            evaluator_free(ctx.eval);
+        }
+    }
+
+    // compute_fitness with the phase invariant fitness, which matches the
+    // whole stride against the resampled target by FFT cross-correlation
+    if (bench_selected(&settings, "compute_fitness")) {
+        fitness_context ctx = {.eval = evaluator_init(target_stride, 256, FKIN_DEFAULT_BACKEND, PRECISION_DOUBLE, 0, 0, 0, true, 1)};
+        bench_run(&settings, "compute_fitness", "res=256,double,phase_invariant", "linkages", 1, bench_compute_fitness, &ctx);
+        evaluator_free(ctx.eval);
+    }
+
+    // compute_fitness_gradient, which sweeps the crank like the long double
+    // fitness and solves the waypoints again in dual numbers
+    if (bench_selected(&settings, "compute_fitness_gradient")) {
+        fitness_context ctx = {.eval = evaluator_init(target_stride, 256, FKIN_DEFAULT_BACKEND, PRECISION_LONG_DOUBLE, 0, 0, 0, false, 1)};
+        bench_run(&settings, "compute_fitness_gradient", "res=256", "linkages", 1, bench_compute_fitness_gradient, &ctx);
+        evaluator_free(ctx.eval);
+    }
+
+    // segments_intersect on random segments in the unit square
+    rng generator;
+    rng_seed(&generator, 1, 0);
+
+    intersect_context *intersect = malloc(sizeof(intersect_context));
+    check_memory(intersect);
+
+    for (size_t i = 0; i < NUM_SEGMENT_PAIRS; i++) {
+        intersect->first[i] = (segment){{rnd(&generator), rnd(&generator)}, {rnd(&generator), rnd(&generator)}};
+        intersect->second[i] = (segment){{rnd(&generator), rnd(&generator)}, {rnd(&generator), rnd(&generator)}};
+    }
+
+    bench_run(&settings, "segments_intersect", "random", "pairs", 1, bench_segments_intersect, intersect);
+    free(intersect);
+
+    // Selection at several population sizes
+    const size_t selection_sizes[] = {100, 1000, 10000, 100000};
+    const size_t num_selection_sizes = sizeof(selection_sizes) / sizeof(selection_sizes[0]);
+
+    for (size_t i = 0; i < num_selection_sizes && bench_selected(&settings, "select_survivors"); i++) {
+        size_t population_size = selection_sizes[i];
+
+        // Distinct linkages with random fitnesses, none of which break
+        selection_context ctx = {
+            .pop = population_init(population_size),
+            .num_survivors = population_size / 4,
+            .buffers = generation_buffers_init(population_size),
+        };
+
+        for (size_t j = 0; j < population_size; j++) {
+            rnd_fill(&generator, ctx.pop->genes[j].lengths, NUM_LINKS);
+            ctx.pop->fitness[j] = -rnd(&generator);
+            ctx.pop->verified[j] = true;
+        }
+
+        for (int deterministic = 1; deterministic >= 0; deterministic--) {
+            ctx.deterministic = deterministic;
+            rng_seed(&ctx.generator, 2, 0);
+            snprintf(variant, sizeof(variant), "n=%zu,%s", population_size, deterministic ? "deterministic" : "stochastic");
+            bench_run(&settings, "select_survivors", variant, "individuals", population_size, bench_select_survivors, &ctx);
+        }
+
+        population_free(ctx.pop);
+        generation_buffers_free(ctx.buffers);
+    }
+
+    // Whole generations at several population sizes, without the cache, so
+    // that the speed does not depend on how far the population has converged
+    const size_t population_sizes[] = {100, 1000, 10000};
+    const size_t num_population_sizes = sizeof(population_sizes) / sizeof(population_sizes[0]);
+    evaluator *eval = evaluator_init(target_stride, 256, FKIN_DEFAULT_BACKEND, PRECISION_DOUBLE, 0, 0, 0, false, num_threads);
+    thread_pool *pool = pool_init(num_threads);
+
+    // The steady state breeds as many children per call as a generation
+    const replacement_policy replacements[] = {REPLACEMENT_GENERATIONAL, REPLACEMENT_WORST};
+    const char *replacement_suffixes[] = {"", ",steady"};
+
+    for (size_t i = 0; i < num_population_sizes && bench_selected(&settings, "evolve_population"); i++) {
+        for (size_t j = 0; j < sizeof(replacements) / sizeof(replacements[0]); j++) {
+            size_t population_size = population_sizes[i];
+            generation_context ctx = {
+                .eval = eval,
+                .num_survivors = population_size / 4,
+                .replacement = replacements[j],
+                .pool = pool,
+                .buffers = generation_buffers_init(population_size),
+            };
+
+            rng_seed(&ctx.generator, 3, 0);
+            ctx.pop = sample_initial_population(population_size, eval, &ctx.generator, pool);
+
+            snprintf(variant, sizeof(variant), "n=%zu,threads=%zu%s", population_size, num_threads, replacement_suffixes[j]);
+            bench_run(&settings, "evolve_population", variant, "offspring", population_size - ctx.num_survivors, bench_evolve_population, &ctx);
+            population_free(ctx.pop);
+            generation_buffers_free(ctx.buffers);
+        }
+    }
+
+    evaluator_free(eval);
+    pool_free(pool);
+    free(target_stride);
+
+    if (settings.json != NULL) {
+        fclose(settings.json);
+    }
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "linkage.h"
+
+/**
+ * @struct fitness_cache
+ * @brief A bounded, thread-safe table of previously computed fitnesses.
+ *
+ * With low mutation and crossover rates, many children are identical to a
+ * parent or to another child, and their fitness is simply looked up. The
+ * table is direct-mapped: every linkage hashes to a single slot, and a new
+ * fitness replaces whatever the slot held. The slots are guarded by a fixed
+ * set of striped locks.
+ *
+ * A cache belongs to a single evaluator. The identity of the evaluator,
+ * i.e. its target stride, resolution, backend and precision, seeds the hash,
+ * so a cache never answers for a different evaluation.
+ *
+ * The structure is opaque; the counters are read with fitness_cache_lookups
+ * and fitness_cache_hits.
+ */
+typedef struct fitness_cache fitness_cache;
+
+/**
+ * @brief Creates a new fitness cache.
+ *
+ * The caller is responsible for freeing the cache with fitness_cache_free.
+ *
+ * @param capacity The number of slots, rounded up to a power of two
+ * @param identity A hash of everything besides the genes that the fitness depends on
+ * @return The new cache
+ */
+fitness_cache *fitness_cache_init(size_t capacity, uint64_t identity);
+
+/**
+ * @brief Looks up the fitness of a linkage.
+ *
+ * @param cache The cache
+ * @param link The linkage
+ * @param fitness The cached fitness, if found
+ * @return true if the fitness was found
+ */
+bool fitness_cache_lookup(fitness_cache *cache, const linkage *link, decimal *fitness);
+
+/**
+ * @brief Stores the fitness of a linkage, evicting the previous occupant of its slot.
+ *
+ * @param cache The cache
+ * @param link The linkage
+ * @param fitness The fitness of the linkage, or -INFINITY if it breaks
+ */
+void fitness_cache_store(fitness_cache *cache, const linkage *link, decimal fitness);
+
+/**
+ * @brief Gets the number of lookups made so far.
+ */
+size_t fitness_cache_lookups(const fitness_cache *cache);
+
+/**
+ * @brief Gets the number of lookups that found a fitness.
+ */
+size_t fitness_cache_hits(const fitness_cache *cache);
+
+/**
+ * @brief Frees a fitness cache.
+ */
+void fitness_cache_free(fitness_cache *cache);
+
+/**
+ * @brief Mixes a 64-bit value into a running hash.
+ *
+ * @param hash The running hash
+ * @param value The value to mix in
+ * @return The new hash
+ */
+uint64_t hash_mix(uint64_t hash, uint64_t value);
+
+/**
+ * @brief Mixes a real number into a running hash.
+ *
+ * The number is rounded to double precision first, so numbers that only
+ * differ beyond double precision hash alike.
+ *
+ * @param hash The running hash
+ * @param value The value to mix in
+ * @return The new hash
+ */
+uint64_t hash_mix_real(uint64_t hash, double value);
+
+#endif // CACHE_H
@@ -0,0 +1,154 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "random.h"
+#include "population.h"
+#include "fkin_batch.h"
+#include "evolution.h"
+
+/** The version of the checkpoint format */
+#define CHECKPOINT_VERSION 6
+
+/**
+ * @struct run_parameters
+ * @brief The parameters that determine how a run evolves.
+ *
+ * @param population_size The number of individuals in the population.
+ * @param num_survivors The number of individuals that survive to reproduce.
+ * @param stride_resolution The number of crank angles sampled per stride.
+ * @param mutation_rate The rate of mutation.
+ * @param crossover_rate The rate of crossover.
+ * @param noise_scale The scale of the noise added to mutated links.
+ * @param noise_absolute Whether the noise is absolute or relative.
+ * @param deterministic_survival Whether the survival is deterministic or stochastic.
+ * @param backend The kernel used to solve the dyads.
+ * @param screening The precision that new individuals are evaluated in.
+ * @param coarse_resolution The resolution offspring are screened at, or 0.
+ * @param coarse_margin The margin of the coarse screen.
+ * @param replacement How the offspring take the place of the population.
+ * @param polish_interval The generations between polishings, or 0.
+ * @param polish_count The number of fittest individuals polished.
+ * @param polish_iterations The most steps of every polishing.
+ * @param phase_invariant Whether the fitness is phase invariant.
+ * @param verify_survivors Whether survivors are verified before they breed.
+ */
+typedef struct run_parameters {
+    size_t population_size;
+    size_t num_survivors;
+    size_t stride_resolution;
+    decimal mutation_rate;
+    decimal crossover_rate;
+    decimal noise_scale;
+    bool noise_absolute;
+    bool deterministic_survival;
+    fkin_backend backend;
+    precision screening;
+    size_t coarse_resolution;
+    decimal coarse_margin;
+    replacement_policy replacement;
+    size_t polish_interval;
+    size_t polish_count;
+    size_t polish_iterations;
+    bool phase_invariant;
+    bool verify_survivors;
+} run_parameters;
+
+/**
+ * @brief Checks if two sets of run parameters are equal
+ *
+ * @param a The first set of parameters
+ * @param b The second set of parameters
+ */
+bool run_parameters_equals(const run_parameters *a, const run_parameters *b);
+
+/**
+ * @struct checkpoint
+ * @brief The state of a run between two generations.
+ *
+ * This is also the layout of a checkpoint file, so a checkpoint is loaded
+ * by mapping the file into memory. The file is only portable between
+ * builds with the same precision and structure layout, which is checked
+ * with the sizes it records.
+ *
+ * @param magic Identifies checkpoint files.
+ * @param version The version of the checkpoint format.
+ * @param decimal_size The size of a decimal in the writing build.
+ * @param individual_size The size of an individual in the writing build.
+ * @param parameters The parameters of the run.
+ * @param seed The seed of the run.
+ * @param generation The generation that the population belongs to.
+ * @param num_children The number of children bred in the steady state.
+ * @param generator The state of the random number stream of the run.
+ * @param best_overall The best individual of all time.
+ * @param population_size The number of individuals that follow.
+ * @param individuals The population.
+ */
+typedef struct checkpoint {
+    char magic[8];
+    uint32_t version;
+    uint32_t decimal_size;
+    uint64_t individual_size;
+    run_parameters parameters;
+    uint64_t seed;
+    uint64_t generation;
+    uint64_t num_children;
+    rng generator;
+    individual best_overall;
+    uint64_t population_size;
+    individual individuals[];
+} checkpoint;
+
+/**
+ * @brief Writes a checkpoint atomically
+ *
+ * The checkpoint is written to a temporary file next to the path, flushed
+ * to disk, and then renamed over the path, so the path always holds either
+ * the previous checkpoint or the new one in full.
+ *
+ * @param path The path of the checkpoint
+ * @param parameters The parameters of the run
+ * @param seed The seed of the run
+ * @param generation The generation of the population
+ * @param num_children The number of children bred in the steady state
+ * @param generator The random number stream of the run
+ * @param best_overall The best individual of all time
+ * @param pop The population
+ */
+void checkpoint_write(const char *path,
+                      const run_parameters *parameters,
+                      uint64_t seed,
+                      size_t generation,
+                      size_t num_children,
+                      const rng *generator,
+                      individual best_overall,
+                      const population *pop);
+
+/**
+ * @brief Maps a checkpoint file into memory
+ *
+ * The file is validated, and the program exits if it is not a checkpoint
+ * written by a compatible build. The caller is responsible for unmapping
+ * the checkpoint with checkpoint_unmap.
+ *
+ * @param path The path of the checkpoint
+ * @return The checkpoint, which is read-only
+ */
+const checkpoint *checkpoint_map(const char *path);
+
+/**
+ * @brief Copies the population out of a checkpoint
+ *
+ * @param ckpt The checkpoint
+ * @return The population
+ */
+population *checkpoint_get_population(const checkpoint *ckpt);
+
+/**
+ * @brief Unmaps a checkpoint.
+ */
+void checkpoint_unmap(const checkpoint *ckpt);
+
+#endif // CHECKPOINT_H
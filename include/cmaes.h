@@ -0,0 +1,67 @@
+#ifndef CMAES_H
+#define CMAES_H
+
+#include "linkage.h"
+#include "evaluator.h"
+#include "population.h"
+#include "pool.h"
+#include "random.h"
+
+/**
+ * @struct cmaes
+ * @brief The state of a covariance matrix adaptation evolution strategy.
+ *
+ * CMA-ES samples every generation from a multivariate normal distribution
+ * over the link lengths, and moves the mean of the distribution towards the
+ * fittest samples. The covariance of the distribution learns the directions
+ * in which the fitness improves, and the step size grows or shrinks with
+ * the progress of the mean, which makes it converge in far fewer
+ * evaluations than the genetic algorithm on smooth fitness landscapes.
+ *
+ * Samples are clamped to [0, 1]. A sample that breaks is drawn again a few
+ * times, and if it keeps breaking, it ranks below every other sample and
+ * takes no part in the update.
+ */
+typedef struct cmaes cmaes;
+
+/**
+ * @brief Creates a CMA-ES centered on a linkage.
+ *
+ * The caller is responsible for freeing the strategy with cmaes_free.
+ *
+ * @param mean The linkage that the first samples are centered on
+ * @param step_size The initial standard deviation of every link length
+ * @param num_samples The number of samples of every generation
+ * @param num_parents The number of fittest samples that the distribution
+ *                    moves towards, at most num_samples
+ * @return The new strategy
+ */
+cmaes *cmaes_init(linkage mean, decimal step_size, size_t num_samples, size_t num_parents);
+
+/**
+ * @brief Samples and evaluates a generation, and updates the distribution
+ *
+ * The samples are evaluated in parallel on the thread pool. Every sample is
+ * drawn from its own stream derived from the generator, so the result does
+ * not depend on the number of threads.
+ *
+ * @param es The strategy
+ * @param pop The population that the samples are written to, whose size is
+ *            the number of samples
+ * @param eval The evaluator used to compute the fitness
+ * @param generator The random number stream
+ * @param pool The thread pool used for evaluation, or NULL to run serially
+ */
+void cmaes_generation(cmaes *es, population *pop, evaluator *eval, rng *generator, thread_pool *pool);
+
+/**
+ * @brief Gets the current step size of the strategy.
+ */
+decimal cmaes_get_step_size(const cmaes *es);
+
+/**
+ * @brief Frees a CMA-ES.
+ */
+void cmaes_free(cmaes *es);
+
+#endif // CMAES_H
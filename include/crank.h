@@ -0,0 +1,62 @@
+#ifndef CRANK_H
+#define CRANK_H
+
+#include <stddef.h>
+#include "trajectory.h"
+
+/**
+ * @struct crank_angle
+ * @brief A crank angle, stored as its cosine and sine.
+ *
+ * @param cos The cosine of the angle.
+ * @param sin The sine of the angle.
+ */
+typedef struct crank_angle {
+    double cos, sin;
+} crank_angle;
+
+/**
+ * @struct crank_table
+ * @brief A table of precomputed crank angles.
+ *
+ * The crank angles visited during a run never change, so their cosines and
+ * sines are computed once and shared by every evaluation, which keeps
+ * transcendental calls out of the crank sweep.
+ *
+ * @param length The number of angles in the table.
+ * @param angles The angles of the table.
+ */
+typedef struct crank_table {
+    size_t length;
+    crank_angle angles[];
+} crank_table;
+
+/**
+ * @brief Initializes a crank table with a given length.
+ *
+ * The angles are not initialized.
+ *
+ * @param length The length of the table.
+ * @return A pointer to the table.
+ */
+crank_table *crank_table_init(size_t length);
+
+/**
+ * @brief Builds the table of a full crank revolution.
+ *
+ * Angle k of the table is 2 pi k / resolution.
+ *
+ * @param resolution The number of angles in a revolution.
+ * @return A pointer to the table.
+ */
+crank_table *crank_table_uniform(size_t resolution);
+
+/**
+ * @brief Builds the table of the crank angles of a trajectory's waypoints.
+ *
+ * @param traj The trajectory.
+ * @return A pointer to the table.
+ */
+crank_table *crank_table_waypoints(trajectory *traj);
+
+#endif // CRANK_H
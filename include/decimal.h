@@ -16,6 +16,7 @@
     #define abs(x) fabs(x)
     #define round(x) round(x)
     #define exp(x) exp(x)
+    #define log(x) log(x)
     #define strto(x) strtod(x)
     #define FORMAT_SPECIFIER "lf"
 #elif USE_FLOAT
@@ -28,6 +29,7 @@
     #define abs(x) fabsf(x)
     #define round(x) roundf(x)
     #define exp(x) expf(x)
+    #define log(x) logf(x)
     #define strto(x) strtof(x)
     #define FORMAT_SPECIFIER "f"
 #else
@@ -40,6 +42,7 @@
     #define abs(x) fabsl(x)
     #define round(x) roundl(x)
     #define exp(x) expl(x)
+    #define log(x) logl(x)
     #define strto(x) strtold(x)
     #define FORMAT_SPECIFIER "Lf"
 #endif
@@ -0,0 +1,163 @@
+#ifndef DUAL_H
+#define DUAL_H
+
+#include <stddef.h>
+#include "decimal.h"
+#include "linkage.h"
+
+/**
+ * @struct dual
+ * @brief A number together with its gradient with respect to the link lengths.
+ *
+ * Dual numbers differentiate in forward mode: every operation computes its
+ * value exactly as the plain operation would, and carries the gradient
+ * along by the chain rule. So a computation written with dual numbers gets
+ * the same value as its plain counterpart, together with the exact partial
+ * derivatives with respect to all 13 link lengths.
+ *
+ * @param value The value of the number.
+ * @param gradient The partial derivatives with respect to every link length.
+ */
+typedef struct dual {
+    decimal value;
+    decimal gradient[NUM_LINKS];
+} dual;
+
+/**
+ * @struct dual_point
+ * @brief A point whose coordinates are dual numbers.
+ */
+typedef struct dual_point {
+    dual x, y;
+} dual_point;
+
+/**
+ * @brief Creates a dual number that does not depend on the link lengths
+ */
+static inline dual dual_constant(decimal value) {
+    dual result = {.value = value};
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        result.gradient[i] = 0;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Creates the dual number of a link length
+ *
+ * @param value The length of the link
+ * @param index The index of the link
+ */
+static inline dual dual_variable(decimal value, size_t index) {
+    dual result = dual_constant(value);
+    result.gradient[index] = 1;
+    return result;
+}
+
+static inline dual dual_add(dual a, dual b) {
+    dual result = {.value = a.value + b.value};
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        result.gradient[i] = a.gradient[i] + b.gradient[i];
+    }
+
+    return result;
+}
+
+static inline dual dual_sub(dual a, dual b) {
+    dual result = {.value = a.value - b.value};
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        result.gradient[i] = a.gradient[i] - b.gradient[i];
+    }
+
+    return result;
+}
+
+static inline dual dual_negate(dual a) {
+    dual result = {.value = -a.value};
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        result.gradient[i] = -a.gradient[i];
+    }
+
+    return result;
+}
+
+static inline dual dual_mul(dual a, dual b) {
+    dual result = {.value = a.value * b.value};
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        result.gradient[i] = a.gradient[i] * b.value + a.value * b.gradient[i];
+    }
+
+    return result;
+}
+
+/**
+ * @brief Multiplies a dual number by a constant
+ */
+static inline dual dual_scale(dual a, decimal factor) {
+    dual result = {.value = a.value * factor};
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        result.gradient[i] = a.gradient[i] * factor;
+    }
+
+    return result;
+}
+
+static inline dual dual_div(dual a, dual b) {
+    dual result = {.value = a.value / b.value};
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        result.gradient[i] = (a.gradient[i] - result.value * b.gradient[i]) / b.value;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Applies a function to a dual number, given its value and derivative there
+ */
+static inline dual dual_apply(dual a, decimal value, decimal derivative) {
+    dual result = {.value = value};
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        result.gradient[i] = derivative * a.gradient[i];
+    }
+
+    return result;
+}
+
+static inline dual dual_sqrt(dual a) {
+    decimal value = sqrt(a.value);
+    return dual_apply(a, value, 1 / (2 * value));
+}
+
+static inline dual dual_sin(dual a) {
+    return dual_apply(a, sin(a.value), cos(a.value));
+}
+
+static inline dual dual_cos(dual a) {
+    return dual_apply(a, cos(a.value), -sin(a.value));
+}
+
+static inline dual dual_acos(dual a) {
+    return dual_apply(a, acos(a.value), -1 / sqrt(1 - a.value * a.value));
+}
+
+static inline dual dual_atan2(dual y, dual x) {
+    dual result = {.value = atan2(y.value, x.value)};
+    decimal norm = x.value * x.value + y.value * y.value;
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        result.gradient[i] = (x.value * y.gradient[i] - y.value * x.gradient[i]) / norm;
+    }
+
+    return result;
+}
+
+#endif // DUAL_H
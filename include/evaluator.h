@@ -0,0 +1,144 @@
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "trajectory.h"
+#include "fkin_batch.h"
+#include "crank.h"
+#include "cache.h"
+#include "telemetry.h"
+#include "point.h"
+#include "fft.h"
+
+/**
+ * @struct evaluator
+ * @brief Everything needed to compute the fitness of a linkage.
+ *
+ * An evaluator is built once per run and shared by every evaluation on
+ * every thread. Apart from its counters, which are atomic, its fitness
+ * cache, which is locked, and the scratch space of every thread, it is
+ * read-only.
+ *
+ * @param target_stride The target path taken by the foot.
+ * @param resolution The number of crank angles sampled per stride.
+ * @param backend The kernel used to solve the dyads.
+ * @param screening The precision that new individuals are evaluated in.
+ * @param stride_angles The crank angles sampled per stride.
+ * @param waypoint_angles The crank angles of the target waypoints.
+ * @param cache The fitnesses computed so far, or NULL if caching is disabled.
+ * @param coarse_resolution The number of crank angles sampled per stride when
+ *                          screening offspring, or 0 to disable screening.
+ * @param coarse_margin How far below the survivor cutoff a screened child may
+ *                      fall and still be evaluated at full resolution.
+ * @param coarse_angles The crank angles sampled when screening offspring.
+ * @param phase_invariant Whether the foot path is compared with the target
+ *                        at the crank phase shift where they match best,
+ *                        rather than at the crank angles of the waypoints.
+ * @param dense_target The target resampled at the crank angles of the
+ *                     stride, or NULL if the fitness is not phase invariant.
+ * @param target_spectrum The Fourier transform of the dense target, or NULL.
+ * @param twiddles The twiddle factors of transforms of the resolution, or NULL.
+ * @param num_threads The number of threads that the scratch space is for.
+ * @param feet_capacity The number of feet in the scratch space of a thread.
+ * @param scratch_feet The feet that a thread keeps during an evaluation, for
+ *                     every thread in turn, which grow with the resolution
+ *                     or the number of waypoints and so are kept off the
+ *                     small stacks of the workers.
+ * @param scratch_correlation The cross-correlation of a phase invariant
+ *                            fitness, for every thread in turn, or NULL.
+ * @param num_verified The number of individuals re-evaluated in long double.
+ * @param num_disagreements The number of verified individuals whose breakage
+ *                          differed between the two precisions.
+ * @param num_broken_sampled The number of offspring that screened broken and
+ *                           were re-evaluated in long double.
+ * @param num_broken_disagreements The number of sampled broken offspring that
+ *                                 do not break in long double.
+ * @param num_screened The number of offspring evaluated at the coarse resolution.
+ * @param num_refined The number of screened offspring re-evaluated at full resolution.
+ * @param num_rank_changes The number of refined offspring that landed on the
+ *                         other side of the survivor cutoff at full resolution.
+ * @param num_evaluations The number of candidate linkages that the search
+ *                        evaluated, at any resolution, which is the cost that
+ *                        search engines are compared by. Verifications are
+ *                        not counted.
+ * @param telemetry The performance counters of the run, or NULL. It is
+ *                  attached by the caller, which keeps ownership of it.
+ */
+typedef struct evaluator {
+    trajectory *target_stride;
+    size_t resolution;
+    fkin_backend backend;
+    precision screening;
+    crank_table *stride_angles;
+    crank_table *waypoint_angles;
+    fitness_cache *cache;
+    size_t coarse_resolution;
+    decimal coarse_margin;
+    crank_table *coarse_angles;
+    bool phase_invariant;
+    point *dense_target;
+    fft_complex *target_spectrum;
+    fft_complex *twiddles;
+    size_t num_threads;
+    size_t feet_capacity;
+    point *scratch_feet;
+    fft_complex *scratch_correlation;
+    atomic_size_t num_verified;
+    atomic_size_t num_disagreements;
+    atomic_size_t num_broken_sampled;
+    atomic_size_t num_broken_disagreements;
+    atomic_size_t num_screened;
+    atomic_size_t num_refined;
+    atomic_size_t num_rank_changes;
+    atomic_size_t num_evaluations;
+    telemetry *telemetry;
+} evaluator;
+
+/**
+ * @brief Creates a new evaluator.
+ *
+ * The evaluator does not take ownership of the trajectory, which must
+ * outlive it. The caller is responsible for freeing the evaluator with
+ * evaluator_free.
+ *
+ * @param target_stride The target path taken by the foot
+ * @param resolution The number of crank angles sampled per stride
+ * @param backend The kernel used to solve the dyads
+ * @param screening The precision that new individuals are evaluated in
+ * @param cache_capacity The number of fitnesses to cache, or 0 to disable caching
+ * @param coarse_resolution The resolution offspring are screened at, or 0 to disable
+ *                          screening. It must divide the resolution, so that the
+ *                          coarse crank angles are a subset of the full ones.
+ * @param coarse_margin How far below the survivor cutoff a screened child may
+ *                      fall and still be evaluated at full resolution
+ * @param phase_invariant Whether the fitness is phase invariant, in which case
+ *                        the resolution must be a power of 2 and there must
+ *                        be no coarse screening
+ * @param num_threads The number of threads of the pool that evaluates
+ * @return The new evaluator
+ */
+evaluator *evaluator_init(trajectory *target_stride, size_t resolution, fkin_backend backend, precision screening, size_t cache_capacity, size_t coarse_resolution, decimal coarse_margin, bool phase_invariant, size_t num_threads);
+
+/**
+ * @brief Gets the feet in the scratch space of the calling thread
+ *
+ * @param eval The evaluator
+ * @return Room for feet_capacity feet
+ */
+point *evaluator_get_scratch_feet(const evaluator *eval);
+
+/**
+ * @brief Gets the cross-correlation in the scratch space of the calling thread
+ *
+ * @param eval The evaluator, whose fitness is phase invariant
+ * @return Room for resolution values
+ */
+fft_complex *evaluator_get_scratch_correlation(const evaluator *eval);
+
+/**
+ * @brief Frees an evaluator.
+ */
+void evaluator_free(evaluator *eval);
+
+#endif // EVALUATOR_H
@@ -2,18 +2,96 @@
 #define EVOLUTION_H
 
 #include "linkage.h"
-#include "trajectory.h"
+#include "evaluator.h"
 #include "population.h"
+#include "pool.h"
+#include "random.h"
+
+/**
+ * @brief How the offspring take the place of the population.
+ *
+ * Generationally, the survivors are selected and the rest of the population
+ * is replaced by their offspring at once. In the steady state, every child
+ * is inserted as soon as it is evaluated, replacing either the weakest
+ * individual of the population or the weakest of a few random individuals
+ * (a tournament), if it is fitter.
+ */
+typedef enum replacement_policy {
+    REPLACEMENT_GENERATIONAL,
+    REPLACEMENT_WORST,
+    REPLACEMENT_TOURNAMENT,
+} replacement_policy;
 
 /**
  * @brief Compute the fitness of the linkage
  * 
+ * The fitness is computed in the screening precision of the evaluator. In
+ * single or double precision, the crank angles of the stride and of the
+ * target waypoints are solved in a single batched sweep, which tracks the
+ * ground and breakage as it goes and stops at the first broken
+ * configuration. No memory is allocated. In long double precision, this is
+ * the same as compute_reference_fitness.
+ * 
+ * If the evaluator has a cache, a linkage that was evaluated before is
+ * looked up instead of being solved again.
+ * 
+ * @param link The linkage structure
+ * @param eval The target stride, resolution and kernel to evaluate with
+ * @return The fitness of the linkage, or -INFINITY if it breaks
+ */
+decimal compute_fitness(linkage link, const evaluator *eval);
+
+/**
+ * @brief Compute the fitness of the linkage in long double precision
+ * 
+ * This solves every configuration with fkin, and is the reference that
+ * screened fitnesses are verified against.
+ * 
+ * @param link The linkage structure
+ * @param eval The target stride and resolution to evaluate with
+ * @return The fitness of the linkage, or -INFINITY if it breaks
+ */
+decimal compute_reference_fitness(linkage link, const evaluator *eval);
+
+/**
+ * @brief Compute the fitness of the linkage and its gradient
+ * 
+ * The fitness is the one computed by compute_reference_fitness. The
+ * gradient is exact: the crank is swept as for the reference fitness, and
+ * the configurations that the fitness depends on, the waypoints and the
+ * lowest foot, are solved again with fkin_dual.
+ * 
  * @param link The linkage structure
- * @param target_stride The target path taken by the foot
- * @param resolution The resolution of the path (i.e. the number of points sampled)
+ * @param eval The target stride and resolution to evaluate with
+ * @param gradient The partial derivatives of the fitness with respect to
+ *                 every link length, which are not written if it breaks
  * @return The fitness of the linkage, or -INFINITY if it breaks
  */
-decimal compute_fitness(linkage link, trajectory *target_stride, size_t resolution);
+decimal compute_fitness_gradient(linkage link, const evaluator *eval, decimal gradient[NUM_LINKS]);
+
+/**
+ * @brief Re-evaluates an individual in long double precision
+ * 
+ * Nothing happens if the individual is already verified. Otherwise, its
+ * fitness is replaced by the reference fitness, and the counters of the
+ * evaluator record whether the two precisions disagreed on breakage.
+ * 
+ * @param specimen The individual
+ * @param eval The evaluator
+ */
+void verify_individual(individual *specimen, evaluator *eval);
+
+/**
+ * @brief Gets the best individual in the population, verifying it first
+ * 
+ * Individuals are verified from the best down until the best individual
+ * has a verified fitness, which is then safe to report.
+ * 
+ * @param pop The population
+ * @param eval The evaluator
+ * @return The best individual
+ */
+individual get_verified_best_individual(population *pop, evaluator *eval);
 
 /**
  * @brief Sample the initial population
@@ -21,12 +99,79 @@ decimal compute_fitness(linkage link, trajectory *target_stride, size_t resoluti
  * All of the linkages in the initial population are randomly generated, but
  * they are guaranteed to not break.
  * 
+ * The candidates are evaluated in parallel on the thread pool. Every
+ * individual is drawn from its own stream derived from the generator, so
+ * the result does not depend on the number of threads.
+ * 
  * @param population_size The size of the population
- * @param target_stride The target path taken by the foot
- * @param resolution The resolution of the path (for breakage checking)
+ * @param eval The evaluator used to compute the fitness
+ * @param generator The random number stream
+ * @param pool The thread pool used for evaluation, or NULL to run serially
  * @return The initial population
  */
-population *sample_initial_population(size_t population_size, trajectory *target_stride, size_t resolution);
+population *sample_initial_population(size_t population_size, evaluator *eval, rng *generator, thread_pool *pool);
+
+/**
+ * @struct generation_buffers
+ * @brief The memory that a population is evolved in.
+ *
+ * The next generation is bred into a second population of the same
+ * capacity, which then trades places with the current one, and the
+ * selection of the survivors and the steady state work in preallocated
+ * scratch space. Once the buffers are created, evolving a population
+ * allocates no memory.
+ */
+typedef struct generation_buffers generation_buffers;
+
+/**
+ * @brief Creates the buffers to evolve a population in.
+ *
+ * The caller is responsible for freeing the buffers with generation_buffers_free.
+ *
+ * @param population_size The largest population that will be evolved
+ * @return The new buffers
+ */
+generation_buffers *generation_buffers_init(size_t population_size);
+
+/**
+ * @brief Frees the buffers to evolve a population in.
+ */
+void generation_buffers_free(generation_buffers *buffers);
+
+/**
+ * @brief Gets the best individual in the population, verifying it without changing the population
+ *
+ * The individuals are verified as in get_verified_best_individual, but in a
+ * copy of the population, so that reporting on the steady state does not
+ * change how it evolves.
+ *
+ * @param pop The population
+ * @param eval The evaluator
+ * @param buffers The buffers, which must have room for the population
+ * @return The best individual
+ */
+individual peek_verified_best_individual(const population *pop, evaluator *eval, generation_buffers *buffers);
+
+/**
+ * @brief Select the survivors of the population
+ * 
+ * If survival is deterministic, then the fittest individuals survive, from
+ * the fittest to the weakest. If survival is stochastic, then the survivors
+ * are drawn with a probability proportional to their fitness. The population
+ * is not modified.
+ * 
+ * The survivors are written to the front of the next generation in the
+ * buffers, which is returned. It must not be freed, and is overwritten by
+ * the next selection.
+ * 
+ * @param pop The population
+ * @param num_survivors The desired number of individuals that survive
+ * @param deterministic_survival Whether the survival is deterministic or stochastic
+ * @param generator The random number stream
+ * @param buffers The buffers, which must have room for the population
+ * @return The survivors
+ */
+population *select_survivors(const population *pop, size_t num_survivors, bool deterministic_survival, rng *generator, generation_buffers *buffers);
 
 /**
  * @brief Evolve the population
@@ -50,24 +195,110 @@ population *sample_initial_population(size_t population_size, trajectory *target
  * individuals are selected to survive based on their fitness, but with a
  * probability proportional to their fitness.
  * 
+ * The offspring are bred and evaluated in parallel on the thread pool. Every
+ * child is drawn from its own stream derived from the generator, so the
+ * result does not depend on the number of threads.
+ * 
+ * The survivors are verified in long double precision before they breed,
+ * unless verify_survivors is false, and the ones that break at that
+ * precision do not survive. If none of them is left, the survivors are
+ * selected again, in the same way, from the individuals of the population
+ * that do not break.
+ * 
+ * If the evaluator has a coarse resolution, every child is first screened
+ * at that resolution, and only the children that come within the coarse
+ * margin of the weakest survivor are evaluated at full resolution.
+ * 
+ * The next generation is bred in the buffers and then swapped into the
+ * population, so no memory is allocated.
+ * 
  * @param pop The current population
- * @param target_stride The target path taken by the foot
+ * @param eval The evaluator used to compute the fitness
  * @param num_survivors The number of individuals that survive to reproduce
  * @param mutation_rate The rate of mutation
  * @param crossover_rate The rate of crossover
  * @param noise_scale The scale of the noise added to the offspring's mutated link
  * @param noise_absolute Whether the noise is absolute or relative.
  * @param deterministic_survival Whether the survival is deterministic or stochastic
- * @param resolution The resolution of the path (for breakage checking)
+ * @param verify_survivors Whether the survivors are verified before they breed
+ * @param generator The random number stream
+ * @param pool The thread pool used for evaluation, or NULL to run serially
+ * @param buffers The buffers, which must have room for the population
  */
 void evolve_population(population *pop,
-                       trajectory *target_stride,
+                       evaluator *eval,
                        size_t num_survivors,
                        decimal mutation_rate,
                        decimal crossover_rate,
                        decimal noise_scale,
                        bool noise_absolute,
                        bool deterministic_survival,
-                       size_t resolution);
+                       bool verify_survivors,
+                       rng *generator,
+                       thread_pool *pool,
+                       generation_buffers *buffers);
+
+/**
+ * @brief Evolve the population in the steady state
+ * 
+ * The threads of the pool breed, evaluate and insert children in a single
+ * stream: every child is bred from the population as it is at that moment,
+ * and inserted as soon as it is evaluated. The threads only wait for each
+ * other when the stream ends, so callers should breed the children of as
+ * many generations per call as they can, e.g. all those up to the next
+ * report. The population is only locked to hold the parent tournaments,
+ * copy the parents and insert a child.
+ * 
+ * The parents are drawn by tournaments, and unless verify_parents is
+ * false, verified in long double before they breed. A child replaces the
+ * weakest individual of the population, or the weakest of a tournament of
+ * random individuals, only if it is fitter.
+ * If the evaluator has a coarse resolution, the fitness of the individual
+ * that the child would replace is the cutoff of the screen.
+ * 
+ * Every child draws from its own stream, which is derived from the seed
+ * and its number in the run. Callers number the children across calls,
+ * starting each call at first_child, so that with a single thread the
+ * result does not depend on how the children are split into calls. With
+ * several threads, it also depends on the order in which they finish.
+ * 
+ * @param pop The population, which is updated in place
+ * @param eval The evaluator used to compute the fitness
+ * @param num_offspring The number of children to breed
+ * @param mutation_rate The rate of mutation
+ * @param crossover_rate The rate of crossover
+ * @param noise_scale The scale of the noise added to the offspring's mutated link
+ * @param noise_absolute Whether the noise is absolute or relative.
+ * @param replacement The individual that a child replaces, which must not be
+ *                    REPLACEMENT_GENERATIONAL
+ * @param verify_parents Whether the parents are verified before they breed
+ * @param seed The seed of the streams of the children
+ * @param first_child The number of the first child in the run
+ * @param pool The thread pool used for evaluation, or NULL to run serially
+ * @param buffers The buffers, which must have room for the population
+ * @return The number of children that were inserted
+ */
+size_t evolve_population_steady_state(population *pop,
+                                      evaluator *eval,
+                                      size_t num_offspring,
+                                      decimal mutation_rate,
+                                      decimal crossover_rate,
+                                      decimal noise_scale,
+                                      bool noise_absolute,
+                                      replacement_policy replacement,
+                                      bool verify_parents,
+                                      uint64_t seed,
+                                      size_t first_child,
+                                      thread_pool *pool,
+                                      generation_buffers *buffers);
+
+/**
+ * @brief Parses the name of a replacement policy ("generational", "worst" or "tournament")
+ *
+ * @param name The name of the policy
+ * @param replacement The parsed policy
+ * @return false if the name is not recognized
+ */
+bool replacement_policy_parse(const char *name, replacement_policy *replacement);
 
 #endif // EVOLUTION_H
\ No newline at end of file
@@ -0,0 +1,56 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @struct fft_complex
+ * @brief A complex number of a transform.
+ *
+ * Transforms are computed in double precision, which is ample for finding
+ * the best match between two curves, and several times faster than long
+ * double.
+ *
+ * @param re The real part.
+ * @param im The imaginary part.
+ */
+typedef struct fft_complex {
+    double re, im;
+} fft_complex;
+
+/**
+ * @brief Checks if a length can be transformed, which is if it is a power of 2
+ */
+bool fft_supports(size_t n);
+
+/**
+ * @brief Computes the twiddle factors of transforms of a length
+ *
+ * The caller is responsible for freeing the factors.
+ *
+ * @param n The length of the transforms, a power of 2
+ * @return The n / 2 factors e^(-2 pi i k / n)
+ */
+fft_complex *fft_twiddles(size_t n);
+
+/**
+ * @brief Computes the discrete Fourier transform of a signal in place
+ *
+ * This is the iterative radix-2 Cooley-Tukey algorithm, which takes
+ * O(n log n) time and allocates no memory.
+ *
+ * @param signal The signal, which is replaced by its transform
+ * @param n The length of the signal, a power of 2
+ * @param twiddles The twiddle factors of the length (see fft_twiddles)
+ * @param inverse Whether to compute the inverse transform instead, which is
+ *                not divided by n
+ */
+void fft(fft_complex *signal, size_t n, const fft_complex *twiddles, bool inverse);
+
+/**
+ * @brief Multiplies a complex number by the conjugate of another
+ */
+fft_complex fft_multiply_conjugate(fft_complex a, fft_complex b);
+
+#endif // FFT_H
@@ -4,6 +4,8 @@
 #include "path.h"
 #include "linkage.h"
 #include "skeleton.h"
+#include "fkin_batch.h"
+#include "dual.h"
 
 /**
  * @brief Compute the forward kinematics of the linkage
@@ -13,13 +15,34 @@
  */
 skeleton fkin(linkage linkage, decimal theta);
 
+/**
+ * @brief Compute the foot of the linkage and its gradient
+ * 
+ * This is fkin in dual numbers, which gives the partial derivatives of the
+ * foot with respect to every link length along with its position. The
+ * position is the one that fkin computes.
+ * 
+ * @param link The linkage structure
+ * @param theta The crank angle
+ * @param foot The foot, whose coordinates carry their gradients
+ * @return false if the skeleton broke, in which case the foot is not written
+ */
+bool fkin_dual(linkage link, decimal theta, dual_point *foot);
+
 /**
  * @brief Compute the path taken by the foot of the skeleton
  * 
+ * The crank angles are solved in batches with fkin_batch. The path is
+ * written to a path owned by the caller, which can be reused from one
+ * linkage to the next, so no memory is allocated.
+ * 
  * @param link The linkage structure
- * @param resolution The resolution of the path (i.e. the number of points sampled)
- * @return The path taken by the foot, or NULL if the skeleton broke
+ * @param crank The crank angles to sample (see crank_table_uniform)
+ * @param backend The kernel used to solve the dyads
+ * @param stride The path taken by the foot, which must have as many points
+ *               as there are crank angles
+ * @return false if the skeleton broke, in which case the path is incomplete
  */
-path *compute_stride(linkage link, size_t resolution);
+bool compute_stride(linkage link, const crank_table *crank, fkin_backend backend, path *stride);
 
 #endif // FKIN_H
\ No newline at end of file
@@ -0,0 +1,152 @@
+#ifndef FKIN_BATCH_H
+#define FKIN_BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "linkage.h"
+#include "prepared.h"
+#include "crank.h"
+#include "skeleton.h"
+
+/** The number of configurations solved together by fkin_batch */
+#define FKIN_BATCH_SIZE 8
+
+/**
+ * @brief The kernels that fkin_batch can solve the dyads with.
+ *
+ * The trigonometric kernel follows fkin: every dyad is solved with atan2,
+ * acos and the cosine and sine of summed angles. The algebraic kernel
+ * intersects the circles directly, rotating unit vectors by the cosine and
+ * sine of each angle, and only needs multiplications, additions and square
+ * roots. Both select the same branch of every dyad and break in the same
+ * configurations.
+ */
+typedef enum fkin_backend {
+    FKIN_TRIGONOMETRIC,
+    FKIN_ALGEBRAIC,
+} fkin_backend;
+
+/**
+ * @brief The floating-point precisions a linkage can be evaluated in.
+ *
+ * The batch kernels run in single or double precision, which vectorize.
+ * Long double precision is only available through fkin, which is the
+ * reference that fast evaluations are verified against.
+ */
+typedef enum precision {
+    PRECISION_FLOAT,
+    PRECISION_DOUBLE,
+    PRECISION_LONG_DOUBLE,
+} precision;
+
+/** The backend used unless another one is selected at run time */
+#ifndef FKIN_DEFAULT_BACKEND
+#define FKIN_DEFAULT_BACKEND FKIN_TRIGONOMETRIC
+#endif
+
+/**
+ * @struct linkage_batch
+ * @brief A batch of linkage configurations in structure-of-arrays layout.
+ *
+ * Every lane holds one configuration, i.e. a prepared linkage and a crank
+ * angle. A batch can hold many linkages at the same angle, one linkage at
+ * many angles, or any mix of the two.
+ *
+ * @param lengths The link lengths, indexed by link and then by lane.
+ * @param squared The squared link lengths, indexed by link and then by lane.
+ * @param gamma The fixed angle between the links b and d of every lane.
+ * @param eta The fixed angle between the links g and i of every lane.
+ * @param cos_gamma The cosine of gamma of every lane.
+ * @param sin_gamma The sine of gamma of every lane.
+ * @param cos_eta The cosine of eta of every lane.
+ * @param sin_eta The sine of eta of every lane.
+ * @param cos_theta The cosine of the crank angle of every lane.
+ * @param sin_theta The sine of the crank angle of every lane.
+ */
+typedef struct linkage_batch {
+    double lengths[NUM_LINKS][FKIN_BATCH_SIZE];
+    double squared[NUM_LINKS][FKIN_BATCH_SIZE];
+    double gamma[FKIN_BATCH_SIZE];
+    double eta[FKIN_BATCH_SIZE];
+    double cos_gamma[FKIN_BATCH_SIZE];
+    double sin_gamma[FKIN_BATCH_SIZE];
+    double cos_eta[FKIN_BATCH_SIZE];
+    double sin_eta[FKIN_BATCH_SIZE];
+    double cos_theta[FKIN_BATCH_SIZE];
+    double sin_theta[FKIN_BATCH_SIZE];
+} linkage_batch;
+
+/**
+ * @struct skeleton_batch
+ * @brief A batch of skeletons in structure-of-arrays layout.
+ *
+ * @param x The x-coordinates of the joints, indexed by joint and then by lane.
+ * @param y The y-coordinates of the joints, indexed by joint and then by lane.
+ * @param broken Whether the skeleton of every lane is broken.
+ */
+typedef struct skeleton_batch {
+    double x[NUM_JOINTS][FKIN_BATCH_SIZE];
+    double y[NUM_JOINTS][FKIN_BATCH_SIZE];
+    bool broken[FKIN_BATCH_SIZE];
+} skeleton_batch;
+
+/**
+ * @brief Sets the configuration of a lane of the batch
+ *
+ * Only the crank angle changes along a sweep, so a sweep sets every lane
+ * once and then only updates the angles with linkage_batch_set_angle.
+ *
+ * @param batch The batch
+ * @param lane The lane to set
+ * @param link The prepared linkage
+ * @param angle The crank angle
+ */
+void linkage_batch_set(linkage_batch *batch, size_t lane, const prepared_linkage *link, crank_angle angle);
+
+/**
+ * @brief Sets the crank angle of a lane of the batch
+ *
+ * @param batch The batch
+ * @param lane The lane to set
+ * @param angle The crank angle
+ */
+static inline void linkage_batch_set_angle(linkage_batch *batch, size_t lane, crank_angle angle) {
+    batch->cos_theta[lane] = angle.cos;
+    batch->sin_theta[lane] = angle.sin;
+}
+
+/**
+ * @brief Compute the forward kinematics of every lane of the batch
+ *
+ * This solves the same equations as fkin, in single or double precision,
+ * for all FKIN_BATCH_SIZE lanes at once. Only the crank-dependent part is solved;
+ * the rest comes from the prepared linkages. The lanes are processed in
+ * lock step without early exits, so the arithmetic can be vectorized. The
+ * joints of a broken lane are unspecified.
+ *
+ * @param in The configurations to solve
+ * @param out The resulting skeletons
+ * @param backend The kernel used to solve the dyads
+ * @param prec The precision of the kernel; long double is solved in double
+ */
+void fkin_batch(const linkage_batch *in, skeleton_batch *out, fkin_backend backend, precision prec);
+
+/**
+ * @brief Parses the name of a backend ("trig" or "algebraic")
+ *
+ * @param name The name of the backend
+ * @param backend The parsed backend
+ * @return false if the name is not recognized
+ */
+bool fkin_backend_parse(const char *name, fkin_backend *backend);
+
+/**
+ * @brief Parses the name of a precision ("float", "double" or "long")
+ *
+ * @param name The name of the precision
+ * @param prec The parsed precision
+ * @return false if the name is not recognized
+ */
+bool precision_parse(const char *name, precision *prec);
+
+#endif // FKIN_BATCH_H
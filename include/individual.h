@@ -3,21 +3,19 @@
 
 #include "linkage.h"
 
+/**
+ * @struct individual
+ * @brief A linkage together with its fitness.
+ *
+ * @param genes The linkage.
+ * @param fitness The fitness of the linkage.
+ * @param verified Whether the fitness was computed in long double precision,
+ *                 rather than only screened in a faster one.
+ */
 typedef struct individual {
     linkage genes;
     decimal fitness;
+    bool verified;
 } individual;
 
-/**
- * @brief Compares two individuals based on their fitness.
- * 
- * This function is used to compare two individuals based on their fitness.
- * It is used for sorting the individuals in the population.
- * 
- * @param a The first individual
- * @param b The second individual
- * @return A negative value if a < b, a positive value if a > b, and 0 if a == b
- */
-int individual_compare(const void *a, const void *b);
-
 #endif // INDIVIDUAL_H
\ No newline at end of file
@@ -0,0 +1,146 @@
+#ifndef ISLAND_H
+#define ISLAND_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "population.h"
+#include "evaluator.h"
+
+/**
+ * @brief The islands that every island receives migrants from.
+ *
+ * On a ring, island i receives from island i - 1 only. On a complete graph,
+ * every island receives from every other island.
+ */
+typedef enum migration_topology {
+    TOPOLOGY_RING,
+    TOPOLOGY_COMPLETE,
+} migration_topology;
+
+/**
+ * @struct archipelago
+ * @brief A set of islands that evolve separately and exchange migrants.
+ *
+ * Every island is a process with its own population. The islands share a
+ * region of memory created with shm_open, which holds an outbox per
+ * island. An island publishes its best individuals to its outbox every few
+ * generations, and collects the newest migrants from the outboxes of its
+ * neighbours, without ever waiting for them. Each outbox is guarded by
+ * its own process-shared mutex, so there is no barrier across islands.
+ *
+ * Since the islands run unsynchronized, which migrants an island receives
+ * depends on timing, and runs with islands are not reproducible.
+ */
+typedef struct archipelago archipelago;
+
+/**
+ * @brief Creates the shared memory of an archipelago.
+ *
+ * The caller is responsible for freeing the archipelago with archipelago_free
+ * in every process.
+ *
+ * @param num_islands The number of islands
+ * @param migration_size The number of individuals that every island sends
+ * @param population_size The size of the population of every island
+ * @param topology The islands that every island receives migrants from
+ * @return The new archipelago
+ */
+archipelago *archipelago_init(size_t num_islands, size_t migration_size, size_t population_size, migration_topology topology);
+
+/**
+ * @brief Forks a process for every island but the first.
+ *
+ * This must be called before any threads are started, since the children
+ * only inherit the calling thread.
+ *
+ * @param islands The archipelago
+ * @return The index of the island of the calling process, which is 0 in the
+ *         original process
+ */
+size_t archipelago_fork(archipelago *islands);
+
+/**
+ * @brief Waits until the processes of the other islands have exited.
+ *
+ * This only waits in the process of the first island, which forked the
+ * others, and returns immediately in any other process.
+ *
+ * @param islands The archipelago
+ */
+void archipelago_join(const archipelago *islands);
+
+/**
+ * @brief Checks whether the process of the first island has exited.
+ *
+ * The other islands should then exit too, rather than evolve forever.
+ *
+ * @param islands The archipelago
+ * @return true if the first island is gone
+ */
+bool archipelago_abandoned(const archipelago *islands);
+
+/**
+ * @brief Publishes the best individuals of an island to its outbox.
+ *
+ * The emigrants are verified in long double first, so that every island
+ * can trust their fitness. They stay in the population.
+ *
+ * @param islands The archipelago
+ * @param island The index of the island
+ * @param pop The population of the island
+ * @param eval The evaluator of the island
+ */
+void archipelago_emigrate(archipelago *islands, size_t island, population *pop, evaluator *eval);
+
+/**
+ * @brief Collects the migrants that the neighbours of an island published.
+ *
+ * Every migrant that has not been collected by this island before replaces
+ * the weakest individual of the population, if the migrant is fitter.
+ *
+ * @param islands The archipelago
+ * @param island The index of the island
+ * @param pop The population of the island
+ * @return The number of migrants that joined the population
+ */
+size_t archipelago_immigrate(archipelago *islands, size_t island, population *pop);
+
+/**
+ * @brief Publishes the best individual found by an island so far.
+ *
+ * @param islands The archipelago
+ * @param island The index of the island
+ * @param best The best individual of the island
+ */
+void archipelago_publish_best(archipelago *islands, size_t island, individual best);
+
+/**
+ * @brief Gets the best individual published by an island.
+ *
+ * @param islands The archipelago
+ * @param island The index of the island
+ * @return The best individual of the island, with a fitness of -INFINITY if
+ *         the island has not published one yet
+ */
+individual archipelago_get_best(archipelago *islands, size_t island);
+
+/**
+ * @brief Gets the number of islands.
+ */
+size_t archipelago_size(const archipelago *islands);
+
+/**
+ * @brief Unmaps the shared memory of an archipelago.
+ */
+void archipelago_free(archipelago *islands);
+
+/**
+ * @brief Parses the name of a topology ("ring" or "complete")
+ *
+ * @param name The name of the topology
+ * @param topology The parsed topology
+ * @return false if the name is not recognized
+ */
+bool migration_topology_parse(const char *name, migration_topology *topology);
+
+#endif // ISLAND_H
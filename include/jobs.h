@@ -0,0 +1,30 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <stddef.h>
+
+/**
+ * @brief Runs every job of a job file on a fixed number of cores
+ *
+ * Every non-empty line of the job file that does not start with # is a
+ * job, written as the arguments of a single run, e.g.
+ *
+ *     trajectory.txt linkage1.txt 10 1000 250 100 0.5 0 0.01 0 1 --seed 1 --generations 500
+ *
+ * Every job must have a budget (--generations, --time or both), and keeps
+ * --threads times --islands cores busy. The jobs are started in order,
+ * each in its own process, as soon as enough cores are free; a job that
+ * does not fit yet lets the following jobs that do fit go first. The
+ * progress of a job is written to its output path with ".log" appended,
+ * and a line is appended to the summary as soon as a job finishes. Jobs
+ * without --seed get distinct seeds, mixed from the clock and their line,
+ * and the summary lists the seed of every job.
+ *
+ * @param job_path The path of the job file
+ * @param num_cores The number of cores that the jobs share
+ * @param summary_path The path of the summary, a tab-separated table
+ * @return 0 if every job succeeded, 1 otherwise
+ */
+int run_jobs(const char *job_path, size_t num_cores, const char *summary_path);
+
+#endif // JOBS_H
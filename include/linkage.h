@@ -34,4 +34,15 @@ bool linkage_equals(linkage a, linkage b);
  */
 void linkage_print(linkage link);
 
+/**
+ * @brief Write the lengths of the linkage to a file
+ * 
+ * The linkage is written to a temporary file next to the path first, which
+ * then replaces the file, so that readers never see it half written.
+ * 
+ * @param path The path of the file
+ * @param link The linkage to write
+ */
+void linkage_write(const char *path, linkage link);
+
 #endif // LINKAGE_H
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef POLISH_H
+#define POLISH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "individual.h"
+#include "evaluator.h"
+#include "population.h"
+#include "pool.h"
+
+/**
+ * @brief Polishes a linkage with a gradient-based local search
+ *
+ * Late in a run, random mutations rarely improve a linkage, while the
+ * gradient of the fitness points straight uphill. The search is a projected
+ * L-BFGS within [0, 1]: links at a bound whose gradient points out of
+ * [0, 1] are held fixed, the quasi-Newton direction is taken over the
+ * others, and the step is clamped to [0, 1] and halved until the fitness
+ * rises enough. Steps that break the linkage are rejected the same way, so
+ * the linkage stays unbroken.
+ *
+ * Every step is evaluated with compute_fitness_gradient, so the polished
+ * fitness is the reference fitness, and the individual is verified.
+ *
+ * @param specimen The individual, which is replaced if polishing improves it
+ * @param eval The evaluator used to compute the fitness and its gradient
+ * @param max_iterations The most steps to take
+ * @return true if the individual was improved
+ */
+bool polish_individual(individual *specimen, evaluator *eval, size_t max_iterations);
+
+/**
+ * @brief Polishes the fittest individuals of a population in parallel
+ *
+ * The individuals are polished in place, so the population keeps its size
+ * and order. Polishing does not draw random numbers, so the outcome does not
+ * depend on the number of threads.
+ *
+ * @param pop The population
+ * @param count The number of fittest individuals to polish
+ * @param max_iterations The most steps to take per individual
+ * @param eval The evaluator used to compute the fitness and its gradient
+ * @param pool The thread pool used for polishing, or NULL to run serially
+ * @return The number of individuals that were improved
+ */
+size_t polish_population(population *pop, size_t count, size_t max_iterations, evaluator *eval, thread_pool *pool);
+
+#endif // POLISH_H
@@ -0,0 +1,74 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+/**
+ * @struct thread_pool
+ * @brief A persistent pool of worker threads.
+ *
+ * The workers are created once and sleep between jobs, so that handing out
+ * work every generation does not pay for thread creation. The thread that
+ * submits a job also takes part in it.
+ */
+typedef struct thread_pool thread_pool;
+
+/**
+ * @brief A unit of work executed by the pool
+ *
+ * @param context The context passed to pool_parallel_for
+ * @param index The index of the item to process
+ */
+typedef void (*pool_task)(void *context, size_t index);
+
+/**
+ * @brief Creates a new thread pool.
+ *
+ * The calling thread counts as one of the threads, so a pool with a single
+ * thread does not spawn any workers and runs everything serially.
+ *
+ * The caller is responsible for freeing the pool with pool_free.
+ *
+ * @param num_threads The total number of threads, including the caller
+ * @return The new thread pool
+ */
+thread_pool *pool_init(size_t num_threads);
+
+/**
+ * @brief Gets the total number of threads in the pool, including the caller.
+ *
+ * A NULL pool counts as a single thread.
+ */
+size_t pool_size(thread_pool *pool);
+
+/**
+ * @brief Gets the index of the calling thread within its pool.
+ *
+ * The thread that submits the jobs is 0, and the workers are numbered from
+ * 1, so the index is always below pool_size. Tasks use it to pick scratch
+ * space that no other thread uses at the same time.
+ */
+size_t pool_thread_index(void);
+
+/**
+ * @brief Runs a task for every index in [0, n) and waits for completion.
+ *
+ * Indices are handed out dynamically, so tasks of uneven cost are balanced
+ * across the threads. The order in which indices are processed is not
+ * specified; tasks must only write to state owned by their index.
+ *
+ * If the pool is NULL, the task is run serially in the calling thread.
+ *
+ * @param pool The thread pool, or NULL
+ * @param n The number of indices
+ * @param task The task to run for every index
+ * @param context The context passed to every task
+ */
+void pool_parallel_for(thread_pool *pool, size_t n, pool_task task, void *context);
+
+/**
+ * @brief Stops the workers and frees the pool.
+ */
+void pool_free(thread_pool *pool);
+
+#endif // POOL_H
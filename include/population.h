@@ -7,12 +7,27 @@
  * @brief A population of individuals.
  * 
  * This structure represents a population of individuals. Each individual
- * is a linkage with a fitness score, and the population contains an array
- * of individuals.
+ * is a linkage with a fitness score. The linkages, the fitnesses and the
+ * verification flags are kept in separate arrays, so that ranking the
+ * population by fitness only streams through the fitnesses, which are a
+ * small fraction of the memory.
+ * 
+ * The arrays have room for capacity individuals, of which the first size
+ * are in the population.
+ * 
+ * @param size The number of individuals in the population.
+ * @param capacity The number of individuals that the arrays have room for.
+ * @param genes The linkages of the individuals.
+ * @param fitness The fitnesses of the individuals.
+ * @param verified Whether the fitness of each individual was computed in long
+ *                 double precision.
  */
 typedef struct population {
     size_t size;
-    individual individuals[];
+    size_t capacity;
+    linkage *genes;
+    decimal *fitness;
+    bool *verified;
 } population;
 
 /**
@@ -20,13 +35,56 @@ typedef struct population {
  * 
  * This function creates a new population with the given size. The population
  * is allocated on the heap, and the caller is responsible for freeing the
- * memory allocated for the population.
+ * memory allocated for the population with population_free.
  * 
- * @param size The size of the population
+ * @param size The size of the population, which is also its capacity
  * @return The new population
  */
 population *population_init(size_t size);
 
+/**
+ * @brief Frees a population.
+ */
+void population_free(population *pop);
+
+/**
+ * @brief Gets an individual of the population.
+ */
+individual population_get(const population *pop, size_t index);
+
+/**
+ * @brief Sets an individual of the population.
+ */
+void population_set(population *pop, size_t index, individual specimen);
+
+/**
+ * @brief Copies an individual of a population into another population.
+ * 
+ * @param dst The population to copy into
+ * @param dst_index The index of the individual to replace
+ * @param src The population to copy from
+ * @param src_index The index of the individual to copy
+ */
+void population_copy_individual(population *dst, size_t dst_index, const population *src, size_t src_index);
+
+/**
+ * @brief Copies the individuals of a population into another population.
+ * 
+ * The capacity of the destination must be at least the size of the source.
+ * 
+ * @param dst The population to copy into
+ * @param src The population to copy from
+ */
+void population_copy(population *dst, const population *src);
+
+/**
+ * @brief Swaps the individuals of two populations, without copying them.
+ * 
+ * This lets the next generation be bred into a second population, which
+ * then takes the place of the current one.
+ */
+void population_swap(population *a, population *b);
+
 /**
  * @brief Computes the mean fitness of the population.
  * 
@@ -36,7 +94,7 @@ population *population_init(size_t size);
  * @param pop The population
  * @return The mean fitness of the population
  */
-decimal population_compute_mean_fitness(population *pop);
+decimal population_compute_mean_fitness(const population *pop);
 
 /**
  * @brief Computes the survival chances of the population.
@@ -44,20 +102,22 @@ decimal population_compute_mean_fitness(population *pop);
  * This function computes the survival chances of the population based on the
  * fitness of each individual. The survival chances are computed as the
  * exponential of the fitness of each individual divided by the total
- * exponential fitness of the population.
- * 
- * The caller is responsible for freeing the memory allocated for the
- * survival chances.
+ * exponential fitness of the population (a softmax). The highest fitness is
+ * subtracted before exponentiating, which does not change the result but
+ * keeps the exponentials from overflowing or all underflowing to zero.
+ * Broken individuals have no chance, and if every individual is broken,
+ * all of the chances are zero.
  * 
  * @param pop The population
- * @return The survival chances of the population
+ * @param survival_chances The survival chances of the individuals, which
+ *                         must have room for the whole population
  */
-decimal *population_compute_survival_chances(population *pop);
+void population_compute_survival_chances(const population *pop, decimal *survival_chances);
 
 /**
  * @brief Gets the best individual in the population.
  */
-individual population_get_best_individual(population *pop);
+individual population_get_best_individual(const population *pop);
 
 /**
  * @brief Computes the fraction of the population that breaks.
@@ -68,6 +128,6 @@ individual population_get_best_individual(population *pop);
  * @param pop The population
  * @return The fraction of the population that breaks
  */
-decimal population_get_breakage_rate(population *pop);
+decimal population_get_breakage_rate(const population *pop);
 
 #endif // POPULATION_H
\ No newline at end of file
@@ -0,0 +1,84 @@
+#ifndef PREPARED_H
+#define PREPARED_H
+
+#include <stdbool.h>
+#include "linkage.h"
+
+/**
+ * @struct prepared_linkage
+ * @brief A linkage together with the values of its kinematics that do not
+ * depend on the crank angle.
+ *
+ * Preparing a linkage once per individual lets a crank sweep skip the
+ * crank-independent part of fkin at every step.
+ *
+ * @param lengths The link lengths.
+ * @param squared The squared link lengths.
+ * @param gamma The angle at B between the links b and d.
+ * @param eta The angle at E between the links g and i.
+ * @param cos_gamma The cosine of gamma.
+ * @param sin_gamma The sine of gamma.
+ * @param cos_eta The cosine of eta.
+ * @param sin_eta The sine of eta.
+ */
+typedef struct prepared_linkage {
+    double lengths[NUM_LINKS];
+    double squared[NUM_LINKS];
+    double gamma;
+    double eta;
+    double cos_gamma;
+    double sin_gamma;
+    double cos_eta;
+    double sin_eta;
+} prepared_linkage;
+
+/** The number of triangle inequalities of the dyads attached to the crank */
+#define NUM_CRANK_BOUNDS 4
+
+/**
+ * @struct crank_interval
+ * @brief An open interval of crank angles.
+ *
+ * @param center The crank angle at the center of the interval.
+ * @param half_width Half the width of the interval, in [0, pi].
+ */
+typedef struct crank_interval {
+    decimal center;
+    decimal half_width;
+} crank_interval;
+
+/**
+ * @brief Computes the crank angles where the dyads attached to the crank break
+ *
+ * The dyads (b, j) and (c, k) at the crank both span the distance AB, which
+ * only depends on the crank angle theta through
+ * 
+ *     AB^2 = m^2 + a^2 + l^2 + 2 m sqrt(a^2 + l^2) cos(theta - phi),
+ * 
+ * where phi = atan2(l, a). A dyad closes when |b - j| <= AB <= b + j (or
+ * |c - k| <= AB <= c + k), so each of the four inequalities fails on an
+ * interval centered on phi, where AB is longest, or on phi + pi, where it is
+ * shortest. Only the non-empty intervals are returned.
+ *
+ * @param link The linkage structure
+ * @param intervals The intervals where an inequality fails
+ * @return The number of non-empty intervals
+ */
+size_t linkage_crank_breakage(linkage link, crank_interval intervals[NUM_CRANK_BOUNDS]);
+
+/**
+ * @brief Prepares a linkage for a crank sweep
+ *
+ * This fails if the linkage breaks at any crank angle because of its
+ * lengths alone, without sampling the crank: either one of its rigid
+ * triangles (b, d, e) or (g, h, i) cannot be closed, or a dyad attached to
+ * the crank cannot be closed for part of the revolution (see
+ * linkage_crank_breakage).
+ *
+ * @param link The linkage structure
+ * @param prepared The prepared linkage
+ * @return false if the linkage is known to break
+ */
+bool linkage_prepare(linkage link, prepared_linkage *prepared);
+
+#endif // PREPARED_H
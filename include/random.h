@@ -1,47 +1,88 @@
 #ifndef RANDOM_H
 #define RANDOM_H
 
+#include <stdint.h>
+#include <stddef.h>
 #include "decimal.h"
 
 /**
- * @brief Generates a random decimal number in the range [0, 1].
+ * @struct rng
+ * @brief The state of a random number stream.
+ *
+ * Each stream is a xoshiro256** generator with its own state, so different
+ * streams can be used from different threads without any synchronization,
+ * and a run is reproducible from its seed.
+ *
+ * @param s The 256-bit state of the generator.
  */
-decimal rnd();
+typedef struct rng {
+    uint64_t s[4];
+} rng;
 
 /**
- * @brief Generates a random decimal number within a specified range.
- * 
- * This function returns a random decimal number that is between the
- * specified lower and upper bounds.
- * 
- * @param lo The lower bound of the range.
- * @param hi The upper bound of the range.
- * @return A random decimal number within the range [lo, hi].
+ * @brief Seeds a random number stream.
+ *
+ * The state is expanded from the seed and the stream identifier with
+ * splitmix64, so different stream identifiers give independent streams
+ * for the same seed.
+ *
+ * @param r The stream to seed.
+ * @param seed The seed of the run.
+ * @param stream The identifier of the stream.
  */
-decimal uniform(decimal lo, decimal hi);
+void rng_seed(rng *r, uint64_t seed, uint64_t stream);
+
+/**
+ * @brief Generates 64 random bits.
+ */
+uint64_t rng_next(rng *r);
+
+/**
+ * @brief Generates a random integer in the range [0, n).
+ *
+ * The result is unbiased. n must be positive.
+ */
+size_t rng_below(rng *r, size_t n);
+
+/**
+ * @brief Generates a random decimal number in the range [0, 1).
+ */
+decimal rnd(rng *r);
 
 /**
  * @brief Generates a random decimal number from a normal distribution.
- * 
+ *
  * This function returns a random decimal number that is normally
  * distributed with the specified mean and standard deviation.
- * 
+ *
+ * @param r The random number stream.
  * @param mean The mean of the normal distribution.
  * @param stddev The standard deviation of the normal distribution.
  * @return A random decimal number from a normal distribution.
  */
-decimal normal(decimal mean, decimal stddev);
+decimal normal(rng *r, decimal mean, decimal stddev);
 
 /**
- * @brief Samples from a discrete distribution.
- * 
- * This function samples from a discrete distribution with the specified
- * probabilities. The probabilities should sum to 1.
- * 
- * @param probs The probability of each outcome.
- * @param n The number of possible outcomes.
- * @return The index of the sampled outcome.
+ * @brief Fills an array with random decimal numbers in the range [0, 1).
+ *
+ * @param r The random number stream.
+ * @param values The array to fill.
+ * @param n The number of values to generate.
+ */
+void rnd_fill(rng *r, decimal *values, size_t n);
+
+/**
+ * @brief Fills an array with random decimal numbers from a normal distribution.
+ *
+ * Unlike repeated calls to normal, both outputs of every Box-Muller
+ * transform are used.
+ *
+ * @param r The random number stream.
+ * @param values The array to fill.
+ * @param n The number of values to generate.
+ * @param mean The mean of the normal distribution.
+ * @param stddev The standard deviation of the normal distribution.
  */
-size_t sample(decimal *probs, size_t n);
+void normal_fill(rng *r, decimal *values, size_t n, decimal mean, decimal stddev);
 
-#endif // RANDOM_H
\ No newline at end of file
+#endif // RANDOM_H
@@ -0,0 +1,136 @@
+#ifndef RUN_H
+#define RUN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "individual.h"
+#include "island.h"
+#include "checkpoint.h"
+
+/**
+ * @brief The search strategy of a run.
+ *
+ * The genetic algorithm breeds the offspring of the survivors, while CMA-ES
+ * samples every generation from a normal distribution that it adapts to the
+ * fittest samples (see cmaes.h).
+ */
+typedef enum search_engine {
+    ENGINE_GA,
+    ENGINE_CMAES,
+} search_engine;
+
+/**
+ * @struct run_config
+ * @brief Everything that describes an evolution run.
+ *
+ * @param trajectory_path The path of the target stride.
+ * @param output_path The path that the best linkage is written to.
+ * @param log_frequency The number of generations between two reports.
+ * @param parameters The parameters that determine how the run evolves.
+ * @param seed The seed of the random number generator.
+ * @param num_threads The number of threads of every island.
+ * @param cache_capacity The number of fitnesses to cache, or 0.
+ * @param num_islands The number of islands.
+ * @param migration_interval The number of generations between two migrations.
+ * @param migration_size The number of individuals that every island sends.
+ * @param topology The islands that every island receives migrants from.
+ * @param checkpoint_path The path of the checkpoint, or NULL.
+ * @param checkpoint_interval The number of generations between two checkpoints.
+ * @param resume_path The path of the checkpoint to resume from, or NULL.
+ * @param trace_path The path of the trace-event file, or NULL.
+ * @param log_path The path of the JSON lines log of the generations, or NULL.
+ * @param dump_interval The number of generations between two dumps of the
+ *                      population to the log, or 0 to never dump it.
+ * @param max_generations The generation at which the run stops, or 0 to run forever.
+ * @param max_seconds The wall time after which the run stops, or 0 to run forever.
+ * @param engine The search strategy.
+ * @param step_size The initial step size of CMA-ES.
+ * @param target_fitness The fitness at which the run stops, or INFINITY to
+ *                       never stop for it.
+ */
+typedef struct run_config {
+    const char *trajectory_path;
+    const char *output_path;
+    size_t log_frequency;
+    run_parameters parameters;
+    uint64_t seed;
+    size_t num_threads;
+    size_t cache_capacity;
+    size_t num_islands;
+    size_t migration_interval;
+    size_t migration_size;
+    migration_topology topology;
+    const char *checkpoint_path;
+    size_t checkpoint_interval;
+    const char *resume_path;
+    const char *trace_path;
+    const char *log_path;
+    size_t dump_interval;
+    size_t max_generations;
+    double max_seconds;
+    search_engine engine;
+    decimal step_size;
+    decimal target_fitness;
+} run_config;
+
+/**
+ * @struct run_result
+ * @brief The outcome of an evolution run.
+ *
+ * @param generations The number of generations reached.
+ * @param seconds The wall time taken by the run.
+ * @param best The best individual of all time.
+ * @param evaluations The number of linkages that the search evaluated. With
+ *                    several islands, this only counts the first island.
+ * @param reached_target Whether the run reached its target fitness.
+ * @param evaluations_to_target The number of evaluations after which the
+ *                              target fitness was reached, counted at the end
+ *                              of the generation that reached it.
+ */
+typedef struct run_result {
+    size_t generations;
+    double seconds;
+    individual best;
+    size_t evaluations;
+    bool reached_target;
+    size_t evaluations_to_target;
+} run_result;
+
+/**
+ * @brief Parses the command-line arguments of a run
+ *
+ * The arguments are the 11 positional arguments, followed by options in
+ * pairs. The strings are not copied, so the arguments must outlive the
+ * configuration. An error is printed if the arguments are invalid.
+ *
+ * @param argc The number of arguments, including the program name
+ * @param argv The arguments, starting with the program name
+ * @param config The parsed configuration
+ * @return false if the arguments are invalid
+ */
+bool run_config_parse(int argc, char *argv[], run_config *config);
+
+/**
+ * @brief Gets the number of cores that a run keeps busy
+ *
+ * @param config The configuration of the run
+ * @return The number of threads of every island times the number of islands
+ */
+size_t run_config_cores(const run_config *config);
+
+/**
+ * @brief Runs the search until its budget is exhausted or its target is reached
+ *
+ * The progress is reported on stdout, and the best linkage of all time is
+ * written to the output path in the background whenever it improves, and
+ * once more at the end. Without a
+ * generation or time budget, the run never returns. With several islands,
+ * only the first island returns; the others exit when they are done.
+ *
+ * @param config The configuration of the run
+ * @return The outcome of the run
+ */
+run_result run_evolution(const run_config *config);
+
+#endif // RUN_H
@@ -0,0 +1,75 @@
+#ifndef RUN_LOG_H
+#define RUN_LOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "individual.h"
+#include "population.h"
+
+/**
+ * @struct generation_record
+ * @brief The statistics of a generation.
+ *
+ * @param generation The index of the generation.
+ * @param seconds The wall time since the run started.
+ * @param mean_fitness The mean fitness of the population.
+ * @param breakage_rate The fraction of the population that breaks.
+ * @param best The best individual of the generation.
+ * @param best_overall The best individual of all time.
+ */
+typedef struct generation_record {
+    size_t generation;
+    double seconds;
+    decimal mean_fitness;
+    decimal breakage_rate;
+    individual best;
+    individual best_overall;
+} generation_record;
+
+/**
+ * @struct run_log
+ * @brief An append-only log of a run, written by a background thread.
+ *
+ * The log is a JSON lines file, with a record per generation, and
+ * optionally a dump of the whole population every few generations. The
+ * writer thread also keeps the output file up to date with the best
+ * linkage of all time. The records are handed to the writer through a
+ * bounded queue, so the evolution never waits for the disk: if the queue
+ * is full, the record is dropped and counted instead.
+ */
+typedef struct run_log run_log;
+
+/**
+ * @brief Creates a run log and starts its writer thread.
+ *
+ * The caller is responsible for freeing the log with run_log_free.
+ *
+ * @param log_path The path of the JSON lines file, or NULL for no log
+ * @param output_path The path of the file that the best linkage of all time
+ *                    is written to, or NULL
+ * @param capacity The number of records that may be waiting to be written
+ * @return The new run log
+ */
+run_log *run_log_init(const char *log_path, const char *output_path, size_t capacity);
+
+/**
+ * @brief Queues the record of a generation without waiting
+ *
+ * @param log The run log
+ * @param record The record of the generation
+ * @param pop The population to dump along with the record, or NULL
+ * @return false if the queue was full and the record was dropped
+ */
+bool run_log_push(run_log *log, const generation_record *record, const population *pop);
+
+/**
+ * @brief Gets the number of records dropped because the queue was full.
+ */
+size_t run_log_dropped(run_log *log);
+
+/**
+ * @brief Writes the remaining records, stops the writer thread and frees the log.
+ */
+void run_log_free(run_log *log);
+
+#endif // RUN_LOG_H
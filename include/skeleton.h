@@ -8,6 +8,54 @@
 /** The number of joints in the skeleton */
 static const size_t NUM_JOINTS = 7;
 
+/** The number of segments in the skeleton */
+#define NUM_SEGMENTS 10
+
+/** The joints at the ends of each segment: AC, AE, BC, BD, BE, CD, DF, EF, EG, FG */
+static const size_t SEGMENT_JOINTS[NUM_SEGMENTS][2] = {
+    {0, 2}, {0, 4}, {1, 2}, {1, 3}, {1, 4}, {2, 3}, {3, 5}, {4, 5}, {4, 6}, {5, 6},
+};
+
+/** The number of pairs of segments that do not share a joint */
+#define NUM_CROSSING_PAIRS 25
+
+/**
+ * The pairs of segments that can cross, as indices into SEGMENT_JOINTS.
+ *
+ * Segments that share a joint cannot cross, so only 25 of the 45 pairs are
+ * tested. The pairs are ordered so that a self-intersecting skeleton is
+ * found as early as possible: the first nine greedily cover every crossing
+ * observed in sampled random and Jansen-like linkages, and the rest follow
+ * by how often they cross.
+ */
+static const size_t CROSSING_PAIRS[NUM_CROSSING_PAIRS][2] = {
+    {4, 6}, // BE, DF
+    {2, 7}, // BC, EF
+    {4, 9}, // BE, FG
+    {2, 9}, // BC, FG
+    {3, 7}, // BD, EF
+    {5, 7}, // CD, EF
+    {0, 8}, // AC, EG
+    {3, 9}, // BD, FG
+    {0, 6}, // AC, DF
+    {4, 5}, // BE, CD
+    {1, 3}, // AE, BD
+    {1, 5}, // AE, CD
+    {1, 6}, // AE, DF
+    {2, 6}, // BC, DF
+    {5, 9}, // CD, FG
+    {3, 8}, // BD, EG
+    {2, 8}, // BC, EG
+    {0, 7}, // AC, EF
+    {0, 9}, // AC, FG
+    {1, 9}, // AE, FG
+    {5, 8}, // CD, EG
+    {0, 3}, // AC, BD
+    {0, 4}, // AC, BE
+    {1, 2}, // AE, BC
+    {6, 8}, // DF, EG
+};
+
 /**
  * @struct skeleton
  * @brief Represents a skeleton structure with 7 joints.
@@ -0,0 +1,185 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <time.h>
+
+/**
+ * @brief The phases of a run that are timed.
+ */
+typedef enum telemetry_phase {
+    PHASE_SAMPLING,
+    PHASE_SELECTION,
+    PHASE_VERIFICATION,
+    PHASE_BREEDING,
+    PHASE_POLISHING,
+    PHASE_MIGRATION,
+    PHASE_CHECKPOINT,
+    PHASE_LOGGING,
+    NUM_PHASES,
+} telemetry_phase;
+
+/** The number of bins of the histogram of the crank steps where breakage is found */
+#define NUM_BREAKAGE_BINS 8
+
+/**
+ * @struct telemetry_totals
+ * @brief The counters and timers of a run at some point in time.
+ *
+ * @param seconds The wall time since the telemetry was created.
+ * @param phase_ns The wall time spent in every phase, in nanoseconds.
+ * @param evaluation_ns The time that the threads spent evaluating, in nanoseconds.
+ * @param num_rejected The number of evaluations that ended before the crank
+ *                     sweep, because the linkage breaks analytically.
+ * @param num_sweeps The number of evaluations that swept the crank.
+ * @param num_fkin The number of crank configurations solved.
+ * @param num_broken The number of sweeps that stopped early at a broken
+ *                   configuration.
+ * @param breakage_bins The number of sweeps that stopped in every eighth of
+ *                      the revolution.
+ */
+typedef struct telemetry_totals {
+    double seconds;
+    uint64_t phase_ns[NUM_PHASES];
+    uint64_t evaluation_ns;
+    uint64_t num_rejected;
+    uint64_t num_sweeps;
+    uint64_t num_fkin;
+    uint64_t num_broken;
+    uint64_t breakage_bins[NUM_BREAKAGE_BINS];
+} telemetry_totals;
+
+/**
+ * @struct telemetry
+ * @brief The performance counters and phase timers of a run.
+ *
+ * The counters are atomic and may be updated from any thread. The phases
+ * are timed on the thread that drives the run, which is also the only
+ * thread that writes the trace. The trace is a Chrome trace-event file,
+ * which can be opened in chrome://tracing or Perfetto. It is flushed at
+ * every report, and stays readable if the run is killed, since the closing
+ * bracket of the event array is optional.
+ *
+ * @param origin The time the telemetry was created, which the trace starts at.
+ * @param trace The trace-event file, or NULL.
+ * @param trace_pid The process that the events of the trace belong to.
+ * @param num_trace_events The number of events written to the trace.
+ * @param phase_ns The wall time spent in every phase, in nanoseconds.
+ * @param evaluation_ns The time that the threads spent evaluating, in nanoseconds.
+ * @param num_rejected The number of evaluations rejected before the sweep.
+ * @param num_sweeps The number of evaluations that swept the crank.
+ * @param num_fkin The number of crank configurations solved.
+ * @param num_broken The number of sweeps that stopped at a broken configuration.
+ * @param breakage_bins The histogram of the crank steps where the sweeps stopped.
+ * @param reported The totals at the last report.
+ */
+typedef struct telemetry {
+    struct timespec origin;
+    FILE *trace;
+    size_t trace_pid;
+    size_t num_trace_events;
+    uint64_t phase_ns[NUM_PHASES];
+    atomic_uint_fast64_t evaluation_ns;
+    atomic_uint_fast64_t num_rejected;
+    atomic_uint_fast64_t num_sweeps;
+    atomic_uint_fast64_t num_fkin;
+    atomic_uint_fast64_t num_broken;
+    atomic_uint_fast64_t breakage_bins[NUM_BREAKAGE_BINS];
+    telemetry_totals reported;
+} telemetry;
+
+/**
+ * @brief Creates the telemetry of a run.
+ *
+ * The caller is responsible for freeing the telemetry with telemetry_free.
+ *
+ * @param trace_path The path of the trace-event file, or NULL for no trace
+ * @param trace_pid The process that the events of the trace belong to
+ * @return The new telemetry
+ */
+telemetry *telemetry_init(const char *trace_path, size_t trace_pid);
+
+/**
+ * @brief Gets the time since the telemetry was created
+ *
+ * @param t The telemetry, or NULL
+ * @return The time in nanoseconds, or 0 if the telemetry is NULL
+ */
+uint64_t telemetry_now(const telemetry *t);
+
+/**
+ * @brief Records a phase that started at the given time and ends now
+ *
+ * This must only be called from the thread that drives the run.
+ *
+ * @param t The telemetry, or NULL
+ * @param phase The phase
+ * @param start The time the phase started, from telemetry_now
+ */
+void telemetry_record_phase(telemetry *t, telemetry_phase phase, uint64_t start);
+
+/**
+ * @brief Records the time that a thread spent evaluating
+ *
+ * @param t The telemetry, or NULL
+ * @param start The time the evaluation started, from telemetry_now
+ */
+void telemetry_record_evaluation(telemetry *t, uint64_t start);
+
+/**
+ * @brief Counts an evaluation that was rejected before the crank sweep
+ *
+ * @param t The telemetry, or NULL
+ */
+void telemetry_count_rejected(telemetry *t);
+
+/**
+ * @brief Counts an evaluation that swept the crank
+ *
+ * @param t The telemetry, or NULL
+ * @param num_fkin The number of crank configurations solved
+ * @param broken Whether the sweep stopped at a broken configuration
+ * @param step The crank step that broke, if the sweep stopped
+ * @param resolution The number of crank steps per revolution
+ */
+void telemetry_count_sweep(telemetry *t, size_t num_fkin, bool broken, size_t step, size_t resolution);
+
+/**
+ * @brief Gets the current totals of the telemetry
+ *
+ * @param t The telemetry
+ * @return The totals
+ */
+telemetry_totals telemetry_get_totals(const telemetry *t);
+
+/**
+ * @brief Prints a summary of the telemetry since the last report
+ *
+ * The rates are also written to the trace as counters.
+ *
+ * @param t The telemetry
+ * @param generation The current generation
+ */
+void telemetry_report(telemetry *t, size_t generation);
+
+/**
+ * @brief Writes the rates since the last report to the trace as counters, without printing them
+ *
+ * Islands other than the first do not print their progress, but still
+ * flush their trace at every report.
+ *
+ * @param t The telemetry
+ * @param generation The current generation
+ */
+void telemetry_flush(telemetry *t, size_t generation);
+
+/**
+ * @brief Closes the trace and frees the telemetry.
+ */
+void telemetry_free(telemetry *t);
+
+#endif // TELEMETRY_H
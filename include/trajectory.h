@@ -28,4 +28,15 @@ typedef struct trajectory {
  */
 trajectory *trajectory_init(size_t length);
 
+/**
+ * @brief Reads a trajectory from a file.
+ * 
+ * Each line of the file holds a waypoint in the format x y t, and the file
+ * should end in an empty line. The program exits if the file cannot be opened.
+ * 
+ * @param path The path of the file.
+ * @return A pointer to the trajectory.
+ */
+trajectory *trajectory_read(const char *path);
+
 #endif // TRAJECTORY_H
\ No newline at end of file
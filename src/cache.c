@@ -0,0 +1,155 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "utils.h"
+#include "cache.h"
+
+/** The number of locks that the slots are striped over */
+#define NUM_CACHE_LOCKS 64
+
+/**
+ * @brief A slot of the cache
+ *
+ * @param occupied Whether the slot holds a fitness
+ * @param genes The linkage whose fitness is held
+ * @param fitness The fitness of the linkage
+ */
+typedef struct cache_slot {
+    bool occupied;
+    linkage genes;
+    decimal fitness;
+} cache_slot;
+
+struct fitness_cache {
+    uint64_t identity;
+    size_t mask;
+    atomic_size_t num_lookups;
+    atomic_size_t num_hits;
+    pthread_mutex_t locks[NUM_CACHE_LOCKS];
+    cache_slot slots[];
+};
+
+uint64_t hash_mix(uint64_t hash, uint64_t value) {
+    // Offset the running hash by the value and scramble it with the
+    // splitmix64 finalizer
+    uint64_t z = hash + 0x9e3779b97f4a7c15ULL + value * 0xff51afd7ed558ccdULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t hash_mix_real(uint64_t hash, double value) {
+    // Both zeros compare equal, so they must hash alike
+    if (value == 0) {
+        value = 0;
+    }
+
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return hash_mix(hash, bits);
+}
+
+/**
+ * @brief Hashes the genes of a linkage for a cache
+ */
+static uint64_t hash_linkage(const fitness_cache *cache, const linkage *link) {
+    uint64_t hash = cache->identity;
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        hash = hash_mix_real(hash, link->lengths[i]);
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Compares the genes of two linkages exactly
+ */
+static bool same_genes(const linkage *a, const linkage *b) {
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        if (a->lengths[i] != b->lengths[i]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+fitness_cache *fitness_cache_init(size_t capacity, uint64_t identity) {
+    size_t num_slots = 1;
+
+    while (num_slots < capacity) {
+        num_slots <<= 1;
+    }
+
+    fitness_cache *cache = malloc(sizeof(fitness_cache) + num_slots * sizeof(cache_slot));
+    check_memory(cache);
+
+    cache->identity = identity;
+    cache->mask = num_slots - 1;
+    atomic_init(&cache->num_lookups, 0);
+    atomic_init(&cache->num_hits, 0);
+
+    for (size_t i = 0; i < NUM_CACHE_LOCKS; i++) {
+        pthread_mutex_init(&cache->locks[i], NULL);
+    }
+
+    for (size_t i = 0; i < num_slots; i++) {
+        cache->slots[i].occupied = false;
+    }
+
+    return cache;
+}
+
+bool fitness_cache_lookup(fitness_cache *cache, const linkage *link, decimal *fitness) {
+    size_t index = hash_linkage(cache, link) & cache->mask;
+    pthread_mutex_t *lock = &cache->locks[index % NUM_CACHE_LOCKS];
+    cache_slot *slot = &cache->slots[index];
+
+    pthread_mutex_lock(lock);
+    bool found = slot->occupied && same_genes(&slot->genes, link);
+
+    if (found) {
+        *fitness = slot->fitness;
+    }
+
+    pthread_mutex_unlock(lock);
+
+    atomic_fetch_add_explicit(&cache->num_lookups, 1, memory_order_relaxed);
+
+    if (found) {
+        atomic_fetch_add_explicit(&cache->num_hits, 1, memory_order_relaxed);
+    }
+
+    return found;
+}
+
+void fitness_cache_store(fitness_cache *cache, const linkage *link, decimal fitness) {
+    size_t index = hash_linkage(cache, link) & cache->mask;
+    pthread_mutex_t *lock = &cache->locks[index % NUM_CACHE_LOCKS];
+    cache_slot *slot = &cache->slots[index];
+
+    pthread_mutex_lock(lock);
+    slot->occupied = true;
+    slot->genes = *link;
+    slot->fitness = fitness;
+    pthread_mutex_unlock(lock);
+}
+
+size_t fitness_cache_lookups(const fitness_cache *cache) {
+    return atomic_load(&cache->num_lookups);
+}
+
+size_t fitness_cache_hits(const fitness_cache *cache) {
+    return atomic_load(&cache->num_hits);
+}
+
+void fitness_cache_free(fitness_cache *cache) {
+    for (size_t i = 0; i < NUM_CACHE_LOCKS; i++) {
+        pthread_mutex_destroy(&cache->locks[i]);
+    }
+
+    free(cache);
+}
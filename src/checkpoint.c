@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "utils.h"
+#include "checkpoint.h"
+
+/** The first bytes of every checkpoint file */
+static const char CHECKPOINT_MAGIC[8] = "STRNDBST";
+
+bool run_parameters_equals(const run_parameters *a, const run_parameters *b) {
+    return a->population_size == b->population_size &&
+           a->num_survivors == b->num_survivors &&
+           a->stride_resolution == b->stride_resolution &&
+           a->mutation_rate == b->mutation_rate &&
+           a->crossover_rate == b->crossover_rate &&
+           a->noise_scale == b->noise_scale &&
+           a->noise_absolute == b->noise_absolute &&
+           a->deterministic_survival == b->deterministic_survival &&
+           a->backend == b->backend &&
+           a->screening == b->screening &&
+           a->coarse_resolution == b->coarse_resolution &&
+           a->coarse_margin == b->coarse_margin &&
+           a->replacement == b->replacement &&
+           a->polish_interval == b->polish_interval &&
+           a->polish_count == b->polish_count &&
+           a->polish_iterations == b->polish_iterations &&
+           a->phase_invariant == b->phase_invariant &&
+           a->verify_survivors == b->verify_survivors;
+}
+
+/**
+ * @brief Computes the size of a checkpoint with a given population size
+ */
+static size_t checkpoint_size(size_t population_size) {
+    return sizeof(checkpoint) + population_size * sizeof(individual);
+}
+
+void checkpoint_write(const char *path,
+                      const run_parameters *parameters,
+                      uint64_t seed,
+                      size_t generation,
+                      size_t num_children,
+                      const rng *generator,
+                      individual best_overall,
+                      const population *pop) {
+    // Clear the header first, so that its padding is written as zeros
+    checkpoint header;
+    memset(&header, 0, sizeof(header));
+
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.decimal_size = sizeof(decimal);
+    header.individual_size = sizeof(individual);
+    header.parameters = *parameters;
+    header.seed = seed;
+    header.generation = generation;
+    header.num_children = num_children;
+    header.generator = *generator;
+    header.best_overall = best_overall;
+    header.population_size = pop->size;
+
+    // Write to a temporary file and move it into place once it is complete
+    size_t temporary_length = strlen(path) + 5;
+    char *temporary_path = malloc(temporary_length);
+    check_memory(temporary_path);
+    snprintf(temporary_path, temporary_length, "%s.tmp", path);
+
+    FILE *file = fopen(temporary_path, "wb");
+
+    if (file == NULL) {
+        fprintf(stderr, "Error: Could not open file %s\n", temporary_path);
+        exit(1);
+    }
+
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    // The individuals are written whole, with their padding cleared
+    for (size_t i = 0; i < pop->size && written; i++) {
+        individual specimen;
+        memset(&specimen, 0, sizeof(specimen));
+        specimen.genes = pop->genes[i];
+        specimen.fitness = pop->fitness[i];
+        specimen.verified = pop->verified[i];
+        written = fwrite(&specimen, sizeof(specimen), 1, file) == 1;
+    }
+
+    written = written &&
+              fflush(file) == 0 &&
+              fsync(fileno(file)) == 0;
+
+    if (fclose(file) != 0 || !written) {
+        fprintf(stderr, "Error: Could not write checkpoint %s\n", temporary_path);
+        exit(1);
+    }
+
+    if (rename(temporary_path, path) != 0) {
+        fprintf(stderr, "Error: Could not move checkpoint %s to %s\n", temporary_path, path);
+        exit(1);
+    }
+
+    free(temporary_path);
+}
+
+const checkpoint *checkpoint_map(const char *path) {
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not open file %s\n", path);
+        exit(1);
+    }
+
+    struct stat status;
+
+    if (fstat(fd, &status) != 0 || (size_t)status.st_size < sizeof(checkpoint)) {
+        fprintf(stderr, "Error: %s is not a checkpoint\n", path);
+        exit(1);
+    }
+
+    void *memory = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (memory == MAP_FAILED) {
+        fprintf(stderr, "Error: Could not map file %s\n", path);
+        exit(1);
+    }
+
+    const checkpoint *ckpt = memory;
+
+    if (memcmp(ckpt->magic, CHECKPOINT_MAGIC, sizeof(ckpt->magic)) != 0) {
+        fprintf(stderr, "Error: %s is not a checkpoint\n", path);
+        exit(1);
+    }
+
+    if (ckpt->version != CHECKPOINT_VERSION || ckpt->decimal_size != sizeof(decimal) || ckpt->individual_size != sizeof(individual)) {
+        fprintf(stderr, "Error: The checkpoint %s was written by an incompatible build\n", path);
+        exit(1);
+    }
+
+    if ((size_t)status.st_size != checkpoint_size(ckpt->population_size)) {
+        fprintf(stderr, "Error: The checkpoint %s is truncated\n", path);
+        exit(1);
+    }
+
+    return ckpt;
+}
+
+population *checkpoint_get_population(const checkpoint *ckpt) {
+    population *pop = population_init(ckpt->population_size);
+
+    for (size_t i = 0; i < ckpt->population_size; i++) {
+        population_set(pop, i, ckpt->individuals[i]);
+    }
+
+    return pop;
+}
+
+void checkpoint_unmap(const checkpoint *ckpt) {
+    munmap((void *)ckpt, checkpoint_size(ckpt->population_size));
+}
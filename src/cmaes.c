@@ -0,0 +1,434 @@
+#include <stdlib.h>
+
+#include "utils.h"
+#include "evolution.h"
+#include "telemetry.h"
+#include "cmaes.h"
+
+/** The number of times a sample that breaks is drawn again */
+#define CMAES_MAX_RESAMPLES 10
+
+/** The most sweeps of the Jacobi eigenvalue algorithm */
+#define JACOBI_MAX_SWEEPS 64
+
+/**
+ * @brief The fitness of a sample together with its index in the population
+ */
+typedef struct ranked_sample {
+    decimal fitness;
+    size_t index;
+} ranked_sample;
+
+/**
+ * The names follow "The CMA Evolution Strategy: A Tutorial" by Hansen, where
+ * the samples are x = mean + step_size * B D z, with z standard normal, so
+ * that the covariance is C = B D^2 B^T.
+ */
+struct cmaes {
+    size_t num_samples;
+    size_t num_parents;
+    decimal *weights;
+    ranked_sample *ranks;
+
+    // The learning rates, which only depend on the dimension and the weights
+    decimal mueff;
+    decimal cc;
+    decimal cs;
+    decimal c1;
+    decimal cmu;
+    decimal damps;
+    decimal chi_n;
+
+    size_t generation;
+    decimal step_size;
+    decimal mean[NUM_LINKS];
+    decimal pc[NUM_LINKS];
+    decimal ps[NUM_LINKS];
+    decimal covariance[NUM_LINKS][NUM_LINKS];
+
+    // The eigenvectors of the covariance, in the columns, and the square
+    // roots of its eigenvalues
+    decimal axes[NUM_LINKS][NUM_LINKS];
+    decimal scales[NUM_LINKS];
+};
+
+cmaes *cmaes_init(linkage mean, decimal step_size, size_t num_samples, size_t num_parents) {
+    cmaes *es = malloc(sizeof(cmaes));
+    check_memory(es);
+
+    es->num_samples = num_samples;
+    es->num_parents = num_parents < num_samples ? num_parents : num_samples;
+    es->weights = malloc(es->num_parents * sizeof(decimal));
+    check_memory(es->weights);
+    es->ranks = malloc(num_samples * sizeof(ranked_sample));
+    check_memory(es->ranks);
+
+    // The fitter a parent, the more it weighs
+    decimal total_weight = 0;
+    decimal total_squared_weight = 0;
+
+    for (size_t i = 0; i < es->num_parents; i++) {
+        es->weights[i] = log(es->num_parents + (decimal)0.5) - log((decimal)(i + 1));
+        total_weight += es->weights[i];
+    }
+
+    for (size_t i = 0; i < es->num_parents; i++) {
+        es->weights[i] /= total_weight;
+        total_squared_weight += es->weights[i] * es->weights[i];
+    }
+
+    decimal n = NUM_LINKS;
+    decimal mueff = 1 / total_squared_weight;
+
+    es->mueff = mueff;
+    es->cc = (4 + mueff / n) / (n + 4 + 2 * mueff / n);
+    es->cs = (mueff + 2) / (n + mueff + 5);
+    es->c1 = 2 / ((n + (decimal)1.3) * (n + (decimal)1.3) + mueff);
+    es->cmu = 2 * (mueff - 2 + 1 / mueff) / ((n + 2) * (n + 2) + mueff);
+
+    if (es->cmu > 1 - es->c1) {
+        es->cmu = 1 - es->c1;
+    }
+
+    decimal excess = sqrt((mueff - 1) / (n + 1)) - 1;
+    es->damps = 1 + 2 * (excess > 0 ? excess : 0) + es->cs;
+    es->chi_n = sqrt(n) * (1 - 1 / (4 * n) + 1 / (21 * n * n));
+
+    es->generation = 0;
+    es->step_size = step_size;
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        es->mean[i] = mean.lengths[i];
+        es->pc[i] = 0;
+        es->ps[i] = 0;
+        es->scales[i] = 1;
+
+        for (size_t j = 0; j < NUM_LINKS; j++) {
+            es->covariance[i][j] = i == j;
+            es->axes[i][j] = i == j;
+        }
+    }
+
+    return es;
+}
+
+/**
+ * @brief Decomposes the covariance into its eigenvectors and eigenvalues
+ *
+ * This is the cyclic Jacobi eigenvalue algorithm, which is simple and
+ * accurate for a matrix this small. Eigenvalues that rounding made
+ * negative or zero are raised to a tiny positive value.
+ */
+static void decompose_covariance(cmaes *es) {
+    decimal a[NUM_LINKS][NUM_LINKS];
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        for (size_t j = 0; j < NUM_LINKS; j++) {
+            // Symmetrize away the rounding errors of the update
+            a[i][j] = (es->covariance[i][j] + es->covariance[j][i]) / 2;
+            es->axes[i][j] = i == j;
+        }
+    }
+
+    for (size_t sweep = 0; sweep < JACOBI_MAX_SWEEPS; sweep++) {
+        decimal off_diagonal = 0;
+
+        for (size_t p = 0; p < NUM_LINKS; p++) {
+            for (size_t q = p + 1; q < NUM_LINKS; q++) {
+                off_diagonal += a[p][q] * a[p][q];
+            }
+        }
+
+        if (off_diagonal == 0) {
+            break;
+        }
+
+        for (size_t p = 0; p < NUM_LINKS; p++) {
+            for (size_t q = p + 1; q < NUM_LINKS; q++) {
+                if (a[p][q] == 0) {
+                    continue;
+                }
+
+                // Rotate rows and columns p and q so that a[p][q] vanishes
+                decimal theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+                decimal t = (theta >= 0 ? 1 : -1) / (abs(theta) + sqrt(theta * theta + 1));
+                decimal c = 1 / sqrt(t * t + 1);
+                decimal s = t * c;
+
+                for (size_t k = 0; k < NUM_LINKS; k++) {
+                    decimal akp = a[k][p];
+                    decimal akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+
+                for (size_t k = 0; k < NUM_LINKS; k++) {
+                    decimal apk = a[p][k];
+                    decimal aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+
+                for (size_t k = 0; k < NUM_LINKS; k++) {
+                    decimal vkp = es->axes[k][p];
+                    decimal vkq = es->axes[k][q];
+                    es->axes[k][p] = c * vkp - s * vkq;
+                    es->axes[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        decimal eigenvalue = a[i][i] > (decimal)1e-20 ? a[i][i] : (decimal)1e-20;
+        es->scales[i] = sqrt(eigenvalue);
+    }
+}
+
+/**
+ * @brief Draws a sample of the distribution
+ */
+static linkage draw_sample(const cmaes *es, rng *stream) {
+    decimal z[NUM_LINKS];
+    normal_fill(stream, z, NUM_LINKS, 0, 1);
+
+    linkage sample;
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        decimal y = 0;
+
+        for (size_t j = 0; j < NUM_LINKS; j++) {
+            y += es->axes[i][j] * es->scales[j] * z[j];
+        }
+
+        decimal length = es->mean[i] + es->step_size * y;
+
+        // Link lengths are in [0, 1]
+        if (length < 0) {
+            length = 0;
+        }
+
+        if (length > 1) {
+            length = 1;
+        }
+
+        sample.lengths[i] = length;
+    }
+
+    return sample;
+}
+
+/**
+ * @brief The shared state of a parallel sampling of a generation
+ */
+typedef struct cmaes_sampling_job {
+    const cmaes *es;
+    population *pop;
+    evaluator *eval;
+    uint64_t seed;
+} cmaes_sampling_job;
+
+/**
+ * @brief Draws and evaluates a single sample, drawing it again while it breaks
+ */
+static void sample_candidate(void *context, size_t index) {
+    cmaes_sampling_job *job = context;
+
+    rng stream;
+    rng_seed(&stream, job->seed, index);
+
+    linkage genes;
+    decimal fitness = -INFINITY;
+
+    uint64_t start = telemetry_now(job->eval->telemetry);
+
+    for (size_t attempt = 0; attempt <= CMAES_MAX_RESAMPLES && fitness == -INFINITY; attempt++) {
+        genes = draw_sample(job->es, &stream);
+        fitness = compute_fitness(genes, job->eval);
+        atomic_fetch_add_explicit(&job->eval->num_evaluations, 1, memory_order_relaxed);
+    }
+
+    telemetry_record_evaluation(job->eval->telemetry, start);
+
+    job->pop->genes[index] = genes;
+    job->pop->fitness[index] = fitness;
+    job->pop->verified[index] = job->eval->screening == PRECISION_LONG_DOUBLE;
+}
+
+/**
+ * @brief Orders ranked samples from the fittest to the weakest
+ */
+static int compare_samples(const void *a, const void *b) {
+    const ranked_sample *rank_a = a;
+    const ranked_sample *rank_b = b;
+
+    if (rank_a->fitness != rank_b->fitness) {
+        return rank_a->fitness < rank_b->fitness ? 1 : -1;
+    }
+
+    return rank_a->index < rank_b->index ? -1 : rank_a->index > rank_b->index;
+}
+
+/**
+ * @brief Moves the distribution towards the fittest samples of the population
+ */
+static void update_distribution(cmaes *es, const population *pop) {
+    for (size_t i = 0; i < pop->size; i++) {
+        es->ranks[i] = (ranked_sample){.fitness = pop->fitness[i], .index = i};
+    }
+
+    qsort(es->ranks, pop->size, sizeof(ranked_sample), compare_samples);
+
+    // Samples that kept breaking take no part, and the weights of the
+    // others are scaled up to make up for them
+    size_t num_parents = 0;
+    decimal total_weight = 0;
+
+    while (num_parents < es->num_parents && num_parents < pop->size && es->ranks[num_parents].fitness != -INFINITY) {
+        total_weight += es->weights[num_parents];
+        num_parents++;
+    }
+
+    if (num_parents == 0) {
+        // Every sample broke, so look closer to the mean
+        es->step_size /= 2;
+        return;
+    }
+
+    decimal total_squared_weight = 0;
+
+    for (size_t k = 0; k < num_parents; k++) {
+        decimal weight = es->weights[k] / total_weight;
+        total_squared_weight += weight * weight;
+    }
+
+    decimal mueff = 1 / total_squared_weight;
+
+    // Move the mean, and keep the step it took in units of the step size
+    decimal step[NUM_LINKS];
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        decimal mean = 0;
+
+        for (size_t k = 0; k < num_parents; k++) {
+            mean += es->weights[k] / total_weight * pop->genes[es->ranks[k].index].lengths[i];
+        }
+
+        step[i] = (mean - es->mean[i]) / es->step_size;
+    }
+
+    // Update the evolution path of the step size with the step whitened by
+    // the covariance, C^(-1/2) step = B D^(-1) B^T step
+    decimal rotated[NUM_LINKS];
+
+    for (size_t j = 0; j < NUM_LINKS; j++) {
+        rotated[j] = 0;
+
+        for (size_t i = 0; i < NUM_LINKS; i++) {
+            rotated[j] += es->axes[i][j] * step[i];
+        }
+
+        rotated[j] /= es->scales[j];
+    }
+
+    decimal ps_rate = sqrt(es->cs * (2 - es->cs) * mueff);
+    decimal ps_norm = 0;
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        decimal whitened = 0;
+
+        for (size_t j = 0; j < NUM_LINKS; j++) {
+            whitened += es->axes[i][j] * rotated[j];
+        }
+
+        es->ps[i] = (1 - es->cs) * es->ps[i] + ps_rate * whitened;
+        ps_norm += es->ps[i] * es->ps[i];
+    }
+
+    ps_norm = sqrt(ps_norm);
+
+    // Stall the evolution path of the covariance while the step size path
+    // is long, so that the covariance does not grow too fast
+    decimal ps_bias = sqrt(1 - exp(2 * (es->generation + 1) * log(1 - es->cs)));
+    bool hsig = ps_norm / ps_bias / es->chi_n < (decimal)1.4 + 2 / ((decimal)NUM_LINKS + 1);
+    decimal pc_rate = sqrt(es->cc * (2 - es->cc) * mueff);
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        es->pc[i] = (1 - es->cc) * es->pc[i] + (hsig ? pc_rate * step[i] : 0);
+    }
+
+    // Update the covariance with the evolution path (rank one) and the
+    // steps of the parents (rank mu)
+    decimal rank_one_correction = hsig ? 0 : es->cc * (2 - es->cc);
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        for (size_t j = 0; j <= i; j++) {
+            decimal rank_mu = 0;
+
+            for (size_t k = 0; k < num_parents; k++) {
+                const linkage *parent = &pop->genes[es->ranks[k].index];
+                decimal yi = (parent->lengths[i] - es->mean[i]) / es->step_size;
+                decimal yj = (parent->lengths[j] - es->mean[j]) / es->step_size;
+                rank_mu += es->weights[k] / total_weight * yi * yj;
+            }
+
+            decimal c = (1 - es->c1 - es->cmu) * es->covariance[i][j] +
+                        es->c1 * (es->pc[i] * es->pc[j] + rank_one_correction * es->covariance[i][j]) +
+                        es->cmu * rank_mu;
+
+            es->covariance[i][j] = c;
+            es->covariance[j][i] = c;
+        }
+    }
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        es->mean[i] += es->step_size * step[i];
+    }
+
+    // Grow the step size if the mean moves further than a random walk would,
+    // and shrink it otherwise. The link lengths span [0, 1], so a larger
+    // step size is of no use.
+    es->step_size *= exp((es->cs / es->damps) * (ps_norm / es->chi_n - 1));
+
+    if (es->step_size > 1) {
+        es->step_size = 1;
+    }
+
+    decompose_covariance(es);
+    es->generation++;
+}
+
+void cmaes_generation(cmaes *es, population *pop, evaluator *eval, rng *generator, thread_pool *pool) {
+    telemetry *t = eval->telemetry;
+
+    cmaes_sampling_job job = {
+        .es = es,
+        .pop = pop,
+        .eval = eval,
+        .seed = rng_next(generator),
+    };
+
+    if (pop->capacity < es->num_samples) {
+        fprintf(stderr, "Error: The population has no room for %zu samples\n", es->num_samples);
+        exit(1);
+    }
+
+    uint64_t start = telemetry_now(t);
+    pop->size = es->num_samples;
+    pool_parallel_for(pool, pop->size, sample_candidate, &job);
+    telemetry_record_phase(t, PHASE_BREEDING, start);
+
+    start = telemetry_now(t);
+    update_distribution(es, pop);
+    telemetry_record_phase(t, PHASE_SELECTION, start);
+}
+
+decimal cmaes_get_step_size(const cmaes *es) {
+    return es->step_size;
+}
+
+void cmaes_free(cmaes *es) {
+    free(es->weights);
+    free(es->ranks);
+    free(es);
+}
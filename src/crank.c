@@ -0,0 +1,42 @@
+#include <stdlib.h>
+
+#include "utils.h"
+#include "crank.h"
+
+/**
+ * @brief Computes a crank angle
+ *
+ * The cosine and sine are computed in the working precision and then
+ * rounded, so the table is at least as accurate as computing them on the
+ * fly.
+ */
+static crank_angle crank_angle_of(decimal theta) {
+    return (crank_angle){.cos = cos(theta), .sin = sin(theta)};
+}
+
+crank_table *crank_table_init(size_t length) {
+    crank_table *table = malloc(sizeof(crank_table) + length * sizeof(crank_angle));
+    check_memory(table);
+    table->length = length;
+    return table;
+}
+
+crank_table *crank_table_uniform(size_t resolution) {
+    crank_table *table = crank_table_init(resolution);
+
+    for (size_t step = 0; step < resolution; step++) {
+        table->angles[step] = crank_angle_of(2 * M_PI * step / resolution);
+    }
+
+    return table;
+}
+
+crank_table *crank_table_waypoints(trajectory *traj) {
+    crank_table *table = crank_table_init(traj->length);
+
+    for (size_t i = 0; i < traj->length; i++) {
+        table->angles[i] = crank_angle_of(traj->waypoints[i].t);
+    }
+
+    return table;
+}
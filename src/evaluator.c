@@ -0,0 +1,223 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "utils.h"
+#include "pool.h"
+#include "evaluator.h"
+
+/**
+ * @brief Hashes everything besides the genes that a fitness depends on
+ */
+static uint64_t evaluator_identity(const evaluator *eval) {
+    uint64_t hash = hash_mix(0, eval->resolution);
+    hash = hash_mix(hash, eval->backend);
+    hash = hash_mix(hash, eval->screening);
+    hash = hash_mix(hash, eval->phase_invariant);
+    hash = hash_mix(hash, eval->target_stride->length);
+
+    for (size_t i = 0; i < eval->target_stride->length; i++) {
+        waypoint target = eval->target_stride->waypoints[i];
+        hash = hash_mix_real(hash, target.x);
+        hash = hash_mix_real(hash, target.y);
+        hash = hash_mix_real(hash, target.t);
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Compares two waypoints by their crank angle in [0, 2 pi)
+ */
+static int compare_waypoint_angles(const void *a, const void *b) {
+    decimal t1 = fmodl(((const waypoint *)a)->t, 2 * M_PI);
+    decimal t2 = fmodl(((const waypoint *)b)->t, 2 * M_PI);
+    t1 += t1 < 0 ? 2 * M_PI : 0;
+    t2 += t2 < 0 ? 2 * M_PI : 0;
+    return (t1 > t2) - (t1 < t2);
+}
+
+/**
+ * @brief Resamples the target into a dense closed curve
+ *
+ * The curve passes through the waypoints in the order of their crank
+ * angles, and is a periodic cubic Hermite spline in the crank angle, whose
+ * tangents are those of Catmull-Rom, so that a few waypoints give a smooth
+ * curve rather than a polygon.
+ *
+ * @param target_stride The waypoints of the target
+ * @param resolution The number of uniformly spaced crank angles to sample
+ * @return The curve at every crank angle, which the caller must free
+ */
+static point *resample_target(const trajectory *target_stride, size_t resolution) {
+    size_t n = target_stride->length;
+    waypoint sorted[n];
+
+    for (size_t i = 0; i < n; i++) {
+        sorted[i] = target_stride->waypoints[i];
+        sorted[i].t = fmodl(sorted[i].t, 2 * M_PI);
+        sorted[i].t += sorted[i].t < 0 ? 2 * M_PI : 0;
+    }
+
+    qsort(sorted, n, sizeof(waypoint), compare_waypoint_angles);
+
+    // Unroll the waypoints by a turn on either side, so that every segment
+    // has a knot before and after it. Segment j runs from knot j to j + 1.
+    waypoint knots[n + 3];
+    knots[0] = sorted[n - 1];
+    knots[0].t -= 2 * M_PI;
+
+    for (size_t i = 0; i < n; i++) {
+        knots[i + 1] = sorted[i];
+    }
+
+    knots[n + 1] = sorted[0];
+    knots[n + 1].t += 2 * M_PI;
+    knots[n + 2] = sorted[1 % n];
+    knots[n + 2].t += 2 * M_PI;
+
+    point *curve = malloc(resolution * sizeof(point));
+    check_memory(curve);
+
+    for (size_t step = 0; step < resolution; step++) {
+        decimal theta = 2 * M_PI * step / resolution;
+
+        // Angles before the first waypoint are on the segment that wraps
+        // around from the last one
+        if (theta < knots[1].t) {
+            theta += 2 * M_PI;
+        }
+
+        // The target has few waypoints, so the segment is searched linearly
+        size_t j = 1;
+
+        while (j < n && knots[j + 1].t <= theta) {
+            j++;
+        }
+
+        waypoint p0 = knots[j];
+        waypoint p1 = knots[j + 1];
+        decimal span = p1.t - p0.t;
+
+        if (span <= 0) {
+            curve[step] = (point){.x = p0.x, .y = p0.y};
+            continue;
+        }
+
+        // The Catmull-Rom tangents at either end, scaled to the segment
+        decimal scale0 = span / (p1.t - knots[j - 1].t);
+        decimal scale1 = span / (knots[j + 2].t - p0.t);
+        point m0 = (point){.x = (p1.x - knots[j - 1].x) * scale0, .y = (p1.y - knots[j - 1].y) * scale0};
+        point m1 = (point){.x = (knots[j + 2].x - p0.x) * scale1, .y = (knots[j + 2].y - p0.y) * scale1};
+
+        decimal u = (theta - p0.t) / span;
+        decimal h00 = 2 * u * u * u - 3 * u * u + 1;
+        decimal h10 = u * u * u - 2 * u * u + u;
+        decimal h01 = -2 * u * u * u + 3 * u * u;
+        decimal h11 = u * u * u - u * u;
+
+        curve[step] = (point){
+            .x = h00 * p0.x + h10 * m0.x + h01 * p1.x + h11 * m1.x,
+            .y = h00 * p0.y + h10 * m0.y + h01 * p1.y + h11 * m1.y,
+        };
+    }
+
+    return curve;
+}
+
+evaluator *evaluator_init(trajectory *target_stride, size_t resolution, fkin_backend backend, precision screening, size_t cache_capacity, size_t coarse_resolution, decimal coarse_margin, bool phase_invariant, size_t num_threads) {
+    evaluator *eval = malloc(sizeof(evaluator));
+    check_memory(eval);
+
+    eval->target_stride = target_stride;
+    eval->resolution = resolution;
+    eval->backend = backend;
+    eval->screening = screening;
+    eval->stride_angles = crank_table_uniform(resolution);
+    eval->waypoint_angles = crank_table_waypoints(target_stride);
+    eval->phase_invariant = phase_invariant;
+    eval->cache = cache_capacity > 0 ? fitness_cache_init(cache_capacity, evaluator_identity(eval)) : NULL;
+    eval->coarse_resolution = coarse_resolution;
+    eval->coarse_margin = coarse_margin;
+    eval->coarse_angles = coarse_resolution > 0 ? crank_table_uniform(coarse_resolution) : NULL;
+    eval->dense_target = NULL;
+    eval->target_spectrum = NULL;
+    eval->twiddles = NULL;
+
+    if (phase_invariant) {
+        eval->dense_target = resample_target(target_stride, resolution);
+        eval->twiddles = fft_twiddles(resolution);
+        eval->target_spectrum = malloc(resolution * sizeof(fft_complex));
+        check_memory(eval->target_spectrum);
+
+        for (size_t i = 0; i < resolution; i++) {
+            eval->target_spectrum[i] = (fft_complex){.re = eval->dense_target[i].x, .im = eval->dense_target[i].y};
+        }
+
+        fft(eval->target_spectrum, resolution, eval->twiddles, false);
+    }
+
+    // A phase invariant fitness keeps the foot at every crank angle, and
+    // the others at every waypoint
+    eval->num_threads = num_threads > 0 ? num_threads : 1;
+    eval->feet_capacity = phase_invariant ? resolution : target_stride->length;
+    eval->feet_capacity = eval->feet_capacity > 0 ? eval->feet_capacity : 1;
+    eval->scratch_feet = malloc(eval->num_threads * eval->feet_capacity * sizeof(point));
+    check_memory(eval->scratch_feet);
+    eval->scratch_correlation = NULL;
+
+    if (phase_invariant) {
+        eval->scratch_correlation = malloc(eval->num_threads * resolution * sizeof(fft_complex));
+        check_memory(eval->scratch_correlation);
+    }
+
+    atomic_init(&eval->num_verified, 0);
+    atomic_init(&eval->num_disagreements, 0);
+    atomic_init(&eval->num_broken_sampled, 0);
+    atomic_init(&eval->num_broken_disagreements, 0);
+    atomic_init(&eval->num_screened, 0);
+    atomic_init(&eval->num_refined, 0);
+    atomic_init(&eval->num_rank_changes, 0);
+    atomic_init(&eval->num_evaluations, 0);
+    eval->telemetry = NULL;
+
+    return eval;
+}
+
+/**
+ * @brief Gets the index of the scratch space of the calling thread
+ */
+static size_t get_scratch_index(const evaluator *eval) {
+    size_t index = pool_thread_index();
+
+    if (index >= eval->num_threads) {
+        fprintf(stderr, "Error: The evaluator has no scratch space for thread %zu\n", index);
+        exit(1);
+    }
+
+    return index;
+}
+
+point *evaluator_get_scratch_feet(const evaluator *eval) {
+    return eval->scratch_feet + get_scratch_index(eval) * eval->feet_capacity;
+}
+
+fft_complex *evaluator_get_scratch_correlation(const evaluator *eval) {
+    return eval->scratch_correlation + get_scratch_index(eval) * eval->resolution;
+}
+
+void evaluator_free(evaluator *eval) {
+    free(eval->stride_angles);
+    free(eval->waypoint_angles);
+    free(eval->coarse_angles);
+    free(eval->dense_target);
+    free(eval->target_spectrum);
+    free(eval->twiddles);
+    free(eval->scratch_feet);
+    free(eval->scratch_correlation);
+
+    if (eval->cache != NULL) {
+        fitness_cache_free(eval->cache);
+    }
+
+    free(eval);
+}
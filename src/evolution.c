@@ -1,9 +1,14 @@
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
 
+#include "utils.h"
+#include "cache.h"
 #include "fkin.h"
-#include "path.h"
 #include "random.h"
 #include "geometry.h"
+#include "fkin_batch.h"
 #include "evolution.h"
 
 /**
@@ -12,87 +17,191 @@
  * The lengths of the links are randomly generated between 0 and 1.
  * Thus, it is possible that the linkage will break.
  */
-static linkage random_linkage() {
+static linkage random_linkage(rng *r) {
     linkage link;
+    rnd_fill(r, link.lengths, NUM_LINKS);
+    return link;
+}
 
-    for (size_t i = 0; i < NUM_LINKS; i++) {
-        link.lengths[i] = rnd();
+/**
+ * @brief The key that an individual is ranked by, such as its fitness,
+ * together with its index in the population
+ *
+ * Ranking these instead of the individuals themselves moves a fraction of
+ * the memory.
+ */
+typedef struct ranked_individual {
+    decimal key;
+    size_t index;
+} ranked_individual;
+
+/**
+ * @brief Checks whether an individual ranks before another
+ *
+ * Higher keys rank first, and ties are broken by the index in the
+ * population, so that the ranking is a total order and does not depend on
+ * the algorithm that computes it.
+ */
+static inline bool ranks_before(const ranked_individual *a, const ranked_individual *b) {
+    return a->key > b->key || (a->key == b->key && a->index < b->index);
+}
+
+/**
+ * @brief Orders ranked individuals from the highest key to the lowest
+ */
+static int compare_ranked(const void *a, const void *b) {
+    const ranked_individual *rank_a = a;
+    const ranked_individual *rank_b = b;
+
+    if (ranks_before(rank_a, rank_b)) {
+        return -1;
     }
 
-    return link;
+    return ranks_before(rank_b, rank_a) ? 1 : 0;
 }
 
 /**
- * @brief Selects the survivors of the population using a stochastic method.
- * 
- * The survival chances of each individual are computed based on their fitness.
- * The survivors are then selected using a stochastic method, where the
- * probability of survival is proportional to the fitness of the individual.
- * 
- * @param pop The population
- * @param num_survivors The number of individuals that survive
- * @return The survivors
+ * @brief Swaps two ranked individuals
  */
-static population *select_survivors_stochastic(population *pop, size_t num_survivors) {
-    // Compute the survival chances of each individual
-    decimal *survival_chances = population_compute_survival_chances(pop);
-    
-    // Select the survivors
-    population *survivors = population_init(num_survivors);
+static inline void swap_ranked(ranked_individual *a, ranked_individual *b) {
+    ranked_individual temporary = *a;
+    *a = *b;
+    *b = temporary;
+}
 
-    for (size_t i = 0; i < num_survivors; i++) {
-        individual survivor;
-        bool duplicate;
+/**
+ * @brief Moves the k first-ranked individuals to the front, in any order
+ *
+ * This is a quickselect with a median-of-three pivot, which takes linear
+ * time on average.
+ *
+ * @param ranks The ranked individuals
+ * @param n The number of ranked individuals
+ * @param k The number of individuals to move to the front
+ */
+static void select_top_k(ranked_individual *ranks, size_t n, size_t k) {
+    size_t lo = 0;
+    size_t hi = n;
 
-        do {
-            size_t survivor_index = sample(survival_chances, pop->size);
-            survivor = pop->individuals[survivor_index];
+    while (hi - lo > 1 && k > lo && k < hi) {
+        // Order the first, middle and last elements, and use the median as
+        // the pivot, which goes to the end of the range
+        size_t mid = lo + (hi - lo) / 2;
 
-            if (survivor.fitness == -INFINITY) {
-                continue;
-            }
+        if (ranks_before(&ranks[mid], &ranks[lo])) {
+            swap_ranked(&ranks[mid], &ranks[lo]);
+        }
 
-            // Check if this survivor was already selected
-            duplicate = false;
+        if (ranks_before(&ranks[hi - 1], &ranks[lo])) {
+            swap_ranked(&ranks[hi - 1], &ranks[lo]);
+        }
 
-            for (size_t j = 0; j < i; j++) {
-                if (linkage_equals(survivors->individuals[j].genes, survivor.genes)) {
-                    duplicate = true;
-                    break;
-                }
+        if (ranks_before(&ranks[hi - 1], &ranks[mid])) {
+            swap_ranked(&ranks[hi - 1], &ranks[mid]);
+        }
+
+        swap_ranked(&ranks[mid], &ranks[hi - 1]);
+        ranked_individual pivot = ranks[hi - 1];
+
+        // Partition the range into those that rank before the pivot and the rest
+        size_t store = lo;
+
+        for (size_t i = lo; i < hi - 1; i++) {
+            if (ranks_before(&ranks[i], &pivot)) {
+                swap_ranked(&ranks[i], &ranks[store++]);
             }
-        } while (duplicate);
+        }
+
+        swap_ranked(&ranks[store], &ranks[hi - 1]);
 
-        survivors->individuals[i] = survivor;
+        // The pivot is now in its final place
+        if (store < k) {
+            lo = store + 1;
+        } else {
+            hi = store;
+        }
     }
+}
 
-    free(survival_chances);
+struct generation_buffers {
+    // The next generation, which is bred here and then swapped in
+    population *next;
 
-    return survivors;
+    // Scratch space for selecting the survivors
+    ranked_individual *ranks;
+    decimal *survival_chances;
+    size_t *slots;
+    size_t num_slots;
+
+    // The indices of the population in a min-heap by fitness, which the
+    // steady state finds the weakest individual with, and the position of
+    // every index in the heap
+    size_t *heap;
+    size_t *heap_positions;
+};
+
+generation_buffers *generation_buffers_init(size_t population_size) {
+    generation_buffers *buffers = malloc(sizeof(generation_buffers));
+    check_memory(buffers);
+
+    buffers->next = population_init(population_size);
+    buffers->ranks = malloc((population_size > 0 ? population_size : 1) * sizeof(ranked_individual));
+    check_memory(buffers->ranks);
+    buffers->survival_chances = malloc((population_size > 0 ? population_size : 1) * sizeof(decimal));
+    check_memory(buffers->survival_chances);
+
+    // The hash table of the stochastic selection is at most half full
+    buffers->num_slots = 1;
+
+    while (buffers->num_slots < 2 * population_size) {
+        buffers->num_slots *= 2;
+    }
+
+    buffers->slots = malloc(buffers->num_slots * sizeof(size_t));
+    check_memory(buffers->slots);
+    buffers->heap = malloc((population_size > 0 ? population_size : 1) * sizeof(size_t));
+    check_memory(buffers->heap);
+    buffers->heap_positions = malloc((population_size > 0 ? population_size : 1) * sizeof(size_t));
+    check_memory(buffers->heap_positions);
+
+    return buffers;
+}
+
+void generation_buffers_free(generation_buffers *buffers) {
+    population_free(buffers->next);
+    free(buffers->ranks);
+    free(buffers->survival_chances);
+    free(buffers->slots);
+    free(buffers->heap);
+    free(buffers->heap_positions);
+    free(buffers);
 }
 
 /**
  * @brief Selects the survivors of the population using a deterministic method.
  * 
- * The individuals with the highest fitnesses are selected as the survivors.
+ * The individuals with the highest fitnesses are selected as the survivors,
+ * from the fittest to the weakest. Only the survivors are sorted: the broken
+ * individuals are left out first, and the survivors are then found with a
+ * quickselect, in linear time on average. The population is not modified.
  * 
  * If there are not enough individuals who don't break, then the actual number
  * of survivors will be less than num_survivors.
  * 
  * @param pop The population
  * @param num_survivors The desired number of individuals that survive
+ * @param buffers The buffers that the survivors are written to
  * @return The survivors
  */
-static population *select_survivors_deterministic(population *pop, size_t num_survivors) {
-    // Sort the population by fitness
-    qsort(pop->individuals, pop->size, sizeof(individual), individual_compare);
+static population *select_survivors_deterministic(const population *pop, size_t num_survivors, generation_buffers *buffers) {
+    ranked_individual *ranks = buffers->ranks;
 
-    // Compute the number of individuals who do not break
+    // Leave out the individuals who break
     size_t num_unbroken = 0;
 
     for (size_t i = 0; i < pop->size; i++) {
-        if (pop->individuals[i].fitness != -INFINITY) {
-            num_unbroken++;
+        if (pop->fitness[i] != -INFINITY) {
+            ranks[num_unbroken++] = (ranked_individual){.key = pop->fitness[i], .index = i};
         }
     }
 
@@ -102,16 +211,139 @@ static population *select_survivors_deterministic(population *pop, size_t num_su
         num_survivors = num_unbroken;
     }
 
-    // Select the survivors
-    population *survivors = population_init(num_survivors);
+    // Find the survivors, and sort only them
+    select_top_k(ranks, num_unbroken, num_survivors);
+    qsort(ranks, num_survivors, sizeof(ranked_individual), compare_ranked);
+
+    population *survivors = buffers->next;
 
     for (size_t i = 0; i < num_survivors; i++) {
-        survivors->individuals[i] = pop->individuals[i];
+        population_copy_individual(survivors, i, pop, ranks[i].index);
     }
 
+    survivors->size = num_survivors;
+
     return survivors;
 }
 
+/**
+ * @brief Hashes the genes of a linkage
+ */
+static uint64_t hash_genes(const linkage *link) {
+    uint64_t hash = 0;
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        hash = hash_mix_real(hash, link->lengths[i]);
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Selects the survivors of the population using a stochastic method.
+ * 
+ * The survival chances of each individual are computed based on their fitness.
+ * The survivors are then selected using a stochastic method, where the
+ * probability of survival is proportional to the fitness of the individual.
+ * 
+ * No linkage survives twice. This is the same as repeatedly drawing an
+ * individual by its survival chance and rejecting the broken ones and the
+ * linkages drawn before, but takes linear time on average and always ends:
+ * 
+ * 1. The copies of every linkage are found with a hash table, and the
+ *    linkage gets the total survival chance w of its copies.
+ * 2. Every distinct linkage draws the key log(u) / w, with u uniform in
+ *    (0, 1]. Taking the linkages with the highest keys, from the highest
+ *    down, is distributed exactly like drawing them one by one without
+ *    replacement (Efraimidis and Spirakis). These are found with the same
+ *    quickselect as the deterministic survivors.
+ * 
+ * If there are fewer distinct linkages that don't break than num_survivors,
+ * then all of them survive.
+ * 
+ * @param pop The population
+ * @param num_survivors The desired number of individuals that survive
+ * @param generator The random number stream
+ * @param buffers The buffers that the survivors are written to
+ * @return The survivors, in the order they would have been drawn
+ */
+static population *select_survivors_stochastic(const population *pop, size_t num_survivors, rng *generator, generation_buffers *buffers) {
+    // Compute the survival chances of each individual
+    decimal *survival_chances = buffers->survival_chances;
+    population_compute_survival_chances(pop, survival_chances);
+
+    // Find the distinct linkages with an open-addressing hash table of
+    // indices into the population, at most half full
+    size_t *slots = buffers->slots;
+    size_t num_slots = buffers->num_slots;
+
+    for (size_t i = 0; i < num_slots; i++) {
+        slots[i] = SIZE_MAX;
+    }
+
+    ranked_individual *ranks = buffers->ranks;
+    size_t num_distinct = 0;
+
+    for (size_t i = 0; i < pop->size; i++) {
+        if (pop->fitness[i] == -INFINITY) {
+            continue;
+        }
+
+        const linkage *genes = &pop->genes[i];
+        size_t slot = hash_genes(genes) & (num_slots - 1);
+
+        while (slots[slot] != SIZE_MAX && !linkage_equals(pop->genes[ranks[slots[slot]].index], *genes)) {
+            slot = (slot + 1) & (num_slots - 1);
+        }
+
+        if (slots[slot] == SIZE_MAX) {
+            // The first copy of the linkage stands for all of them, and
+            // collects their survival chances in the place of the key
+            slots[slot] = num_distinct;
+            ranks[num_distinct++] = (ranked_individual){.key = survival_chances[i], .index = i};
+        } else {
+            ranks[slots[slot]].key += survival_chances[i];
+        }
+    }
+
+    // Draw a key for every distinct linkage
+    for (size_t i = 0; i < num_distinct; i++) {
+        decimal u = 1 - rnd(generator);
+        ranks[i].key = log(u) / ranks[i].key;
+    }
+
+    if (num_distinct < num_survivors) {
+        num_survivors = num_distinct;
+    }
+
+    // The linkages with the highest keys survive
+    select_top_k(ranks, num_distinct, num_survivors);
+    qsort(ranks, num_survivors, sizeof(ranked_individual), compare_ranked);
+
+    population *survivors = buffers->next;
+
+    for (size_t i = 0; i < num_survivors; i++) {
+        population_copy_individual(survivors, i, pop, ranks[i].index);
+    }
+
+    survivors->size = num_survivors;
+
+    return survivors;
+}
+
+population *select_survivors(const population *pop, size_t num_survivors, bool deterministic_survival, rng *generator, generation_buffers *buffers) {
+    if (pop->size > buffers->next->capacity) {
+        fprintf(stderr, "Error: The population of %zu individuals does not fit in the buffers\n", pop->size);
+        exit(1);
+    }
+
+    if (deterministic_survival) {
+        return select_survivors_deterministic(pop, num_survivors, buffers);
+    }
+
+    return select_survivors_stochastic(pop, num_survivors, generator, buffers);
+}
+
 /**
  * @brief Mutates a value
  * 
@@ -124,17 +356,18 @@ static population *select_survivors_deterministic(population *pop, size_t num_su
  * 
  * The mutated value is clamped to the range [0, 1].
  * 
+ * @param r The random number stream
  * @param value The value to mutate
  * @param noise_scale The scale of the noise
  * @param noise_absolute Whether the noise is absolute or relative
  * @return The mutated value
  */
-static decimal mutate(decimal value, decimal noise_scale, bool noise_absolute) {
+static decimal mutate(rng *r, decimal value, decimal noise_scale, bool noise_absolute) {
     if (noise_absolute) {
-        return rnd();
+        return rnd(r);
     }
 
-    decimal noise = normal(0, value * noise_scale);
+    decimal noise = normal(r, 0, value * noise_scale);
     decimal mutated_value = value + noise;
 
     if (mutated_value < 0) {
@@ -148,32 +381,208 @@ static decimal mutate(decimal value, decimal noise_scale, bool noise_absolute) {
     return mutated_value;
 }
 
-decimal compute_fitness(linkage link, trajectory *target_stride, size_t resolution) {
-    // Do some basic geometric checks
-    decimal b = link.lengths[1];
-    decimal d = link.lengths[3];
-    decimal e = link.lengths[4];
-    decimal g = link.lengths[6];
-    decimal h = link.lengths[7];
-    decimal i = link.lengths[8];
+/**
+ * @brief Computes the mean distance between the stride and the dense target at their best phase shift
+ *
+ * The shift that minimizes the squared distance between the two curves
+ * maximizes the real part of their circular cross-correlation, with the
+ * points taken as complex numbers x + iy. It is computed for every shift at
+ * once with two Fourier transforms, in O(n log n) rather than the O(n^2) of
+ * trying every shift. The fitness is the mean distance at that shift.
+ *
+ * @param eval The evaluator, whose fitness is phase invariant
+ * @param feet The foot at every crank angle of the stride
+ * @param ground The y-coordinate of the ground
+ * @return The mean distance
+ */
+static decimal compute_phase_invariant_error(const evaluator *eval, const point *feet, decimal ground) {
+    size_t resolution = eval->resolution;
+    fft_complex *correlation = evaluator_get_scratch_correlation(eval);
+
+    for (size_t i = 0; i < resolution; i++) {
+        correlation[i] = (fft_complex){.re = feet[i].x, .im = feet[i].y - ground};
+    }
+
+    fft(correlation, resolution, eval->twiddles, false);
+
+    for (size_t i = 0; i < resolution; i++) {
+        correlation[i] = fft_multiply_conjugate(correlation[i], eval->target_spectrum[i]);
+    }
+
+    fft(correlation, resolution, eval->twiddles, true);
+
+    size_t best_shift = 0;
+
+    for (size_t shift = 1; shift < resolution; shift++) {
+        if (correlation[shift].re > correlation[best_shift].re) {
+            best_shift = shift;
+        }
+    }
+
+    // Compare the shifted stride with the dense target
+    decimal total_error = 0;
+
+    for (size_t i = 0; i < resolution; i++) {
+        point foot = feet[(i + best_shift) % resolution];
+        foot.y -= ground;
+        total_error += distance(foot, eval->dense_target[i]);
+    }
+
+    return total_error / resolution;
+}
+
+/**
+ * @brief Computes the fitness of the linkage with the batch kernels
+ *
+ * @param link The linkage structure
+ * @param eval The evaluator
+ * @param stride_angles The crank angles that breakage and the ground are checked at
+ * @param prec The precision of the kernels (single or double)
+ * @return The fitness of the linkage, or -INFINITY if it breaks
+ */
+static decimal compute_batch_fitness(linkage link, const evaluator *eval, const crank_table *stride_angles, precision prec) {
+    // Do the crank-independent work once, and check that the rigid triangles
+    // of the linkage can be closed
+    prepared_linkage prepared;
 
-    if (b + d <= e || g + h <= i) {
+    if (!linkage_prepare(link, &prepared)) {
+        telemetry_count_rejected(eval->telemetry);
         return -INFINITY;
     }
 
-    // Compute the path taken by the foot
-    path *p = compute_stride(link, resolution);
+    // Sweep the crank in a single pass. The first resolution configurations
+    // are the sampled crank angles, which determine breakage and the ground,
+    // and the remaining ones are the crank angles of the target waypoints.
+    // The feet at the waypoints are kept until the ground is known.
+    // A phase invariant fitness keeps the feet at the sampled crank angles
+    // instead, and does not solve the waypoints.
+    trajectory *target_stride = eval->target_stride;
+    size_t resolution = stride_angles->length;
+    size_t num_waypoints = eval->phase_invariant ? 0 : target_stride->length;
+    size_t num_configurations = resolution + num_waypoints;
+
+    decimal ground = INFINITY;
+    point *feet = evaluator_get_scratch_feet(eval);
+
+    linkage_batch batch;
+    skeleton_batch skel;
+
+    for (size_t lane = 0; lane < FKIN_BATCH_SIZE; lane++) {
+        linkage_batch_set(&batch, lane, &prepared, stride_angles->angles[0]);
+    }
+
+    for (size_t start = 0; start < num_configurations; start += FKIN_BATCH_SIZE) {
+        size_t count = num_configurations - start < FKIN_BATCH_SIZE ? num_configurations - start : FKIN_BATCH_SIZE;
+
+        // If the number of configurations is not a multiple of the batch
+        // size, the last one fills the spare lanes
+        for (size_t lane = 0; lane < FKIN_BATCH_SIZE; lane++) {
+            size_t index = start + (lane < count ? lane : count - 1);
+
+            if (index < resolution) {
+                linkage_batch_set_angle(&batch, lane, stride_angles->angles[index]);
+            } else {
+                linkage_batch_set_angle(&batch, lane, eval->waypoint_angles->angles[index - resolution]);
+            }
+        }
+
+        fkin_batch(&batch, &skel, eval->backend, prec);
+
+        for (size_t lane = 0; lane < count; lane++) {
+            size_t index = start + lane;
+            point foot = (point){.x = skel.x[NUM_JOINTS - 1][lane], .y = skel.y[NUM_JOINTS - 1][lane]};
+
+            if (index < resolution) {
+                // Check if the linkage broke
+                if (skel.broken[lane]) {
+                    telemetry_count_sweep(eval->telemetry, start + FKIN_BATCH_SIZE, true, index, resolution);
+                    return -INFINITY;
+                }
+
+                if (foot.y < ground) {
+                    ground = foot.y;
+                }
+
+                if (eval->phase_invariant) {
+                    feet[index] = foot;
+                }
+            } else {
+                // The joints of a broken lane are unspecified, so a foot that
+                // breaks at a waypoint is taken to be at the origin, as fkin
+                // and the reference fitness do
+                feet[index - resolution] = skel.broken[lane] ? (point){0, 0} : foot;
+            }
+        }
+    }
+
+    telemetry_count_sweep(eval->telemetry, num_configurations, false, 0, resolution);
+
+    if (eval->phase_invariant) {
+        return -compute_phase_invariant_error(eval, feet, ground);
+    }
 
-    // Check if the linkage broke
-    if (p == NULL) {
+    // Compare the path taken by the foot with the target path
+    decimal total_error = 0;
+
+    for (size_t i = 0; i < num_waypoints; i++) {
+        waypoint target_waypoint = target_stride->waypoints[i];
+        point target_foot = (point){.x = target_waypoint.x, .y = target_waypoint.y};
+        point foot = feet[i];
+
+        foot.y -= ground;
+
+        // Compute the distance between the foot and the target foot
+        total_error += distance(foot, target_foot);
+    }
+
+    decimal mean_error = total_error / target_stride->length;
+    decimal fitness = -mean_error;
+
+    return fitness;
+}
+
+decimal compute_reference_fitness(linkage link, const evaluator *eval) {
+    prepared_linkage prepared;
+
+    if (!linkage_prepare(link, &prepared)) {
+        telemetry_count_rejected(eval->telemetry);
         return -INFINITY;
     }
 
-    // Get the y-coordinate of the ground
-    decimal ground = path_get_ground(p);
+    trajectory *target_stride = eval->target_stride;
+    size_t resolution = eval->resolution;
 
-    // Free the path
-    free(p);
+    // Get the y-coordinate of the ground, checking that the linkage does not
+    // break along the way. A phase invariant fitness keeps every foot.
+    decimal ground = INFINITY;
+    point *feet = evaluator_get_scratch_feet(eval);
+
+    for (size_t step = 0; step < resolution; step++) {
+        decimal crank_angle = 2 * M_PI * step / resolution;
+        skeleton skel = fkin(link, crank_angle);
+
+        if (skel.broken) {
+            telemetry_count_sweep(eval->telemetry, step + 1, true, step, resolution);
+            return -INFINITY;
+        }
+
+        point foot = skeleton_get_foot(skel);
+
+        if (foot.y < ground) {
+            ground = foot.y;
+        }
+
+        if (eval->phase_invariant) {
+            feet[step] = foot;
+        }
+    }
+
+    if (eval->phase_invariant) {
+        telemetry_count_sweep(eval->telemetry, resolution, false, 0, resolution);
+        return -compute_phase_invariant_error(eval, feet, ground);
+    }
+
+    telemetry_count_sweep(eval->telemetry, resolution + target_stride->length, false, 0, resolution);
 
     // Compare the path taken by the foot with the target path
     decimal total_error = 0;
@@ -190,86 +599,910 @@ decimal compute_fitness(linkage link, trajectory *target_stride, size_t resoluti
         // Compute the distance between the foot and the target foot
         total_error += distance(foot, target_foot);
     }
-    
+
     decimal mean_error = total_error / target_stride->length;
     decimal fitness = -mean_error;
 
     return fitness;
 }
 
-population *sample_initial_population(size_t population_size, trajectory *target_stride, size_t resolution) {
-    population *initial_population = population_init(population_size);
+decimal compute_fitness_gradient(linkage link, const evaluator *eval, decimal gradient[NUM_LINKS]) {
+    if (eval->phase_invariant) {
+        fprintf(stderr, "Error: The gradient of a phase invariant fitness is not supported\n");
+        exit(1);
+    }
+
+    prepared_linkage prepared;
+
+    if (!linkage_prepare(link, &prepared)) {
+        telemetry_count_rejected(eval->telemetry);
+        return -INFINITY;
+    }
+
+    trajectory *target_stride = eval->target_stride;
+    size_t resolution = eval->resolution;
+
+    // Sweep the crank as compute_reference_fitness does. The ground only
+    // moves with the lowest foot, so only that configuration is solved
+    // again in dual numbers.
+    decimal ground = INFINITY;
+    size_t ground_step = 0;
+
+    for (size_t step = 0; step < resolution; step++) {
+        decimal crank_angle = 2 * M_PI * step / resolution;
+        skeleton skel = fkin(link, crank_angle);
+
+        if (skel.broken) {
+            telemetry_count_sweep(eval->telemetry, step + 1, true, step, resolution);
+            return -INFINITY;
+        }
+
+        point foot = skeleton_get_foot(skel);
+
+        if (foot.y < ground) {
+            ground = foot.y;
+            ground_step = step;
+        }
+    }
+
+    telemetry_count_sweep(eval->telemetry, resolution + target_stride->length + 1, false, 0, resolution);
+
+    dual_point lowest_foot;
+
+    if (!fkin_dual(link, 2 * M_PI * ground_step / resolution, &lowest_foot)) {
+        return -INFINITY;
+    }
+
+    // Compare the path taken by the foot with the target path
+    dual total_error = dual_constant(0);
+
+    for (size_t i = 0; i < target_stride->length; i++) {
+        waypoint target_waypoint = target_stride->waypoints[i];
+        dual_point foot;
+
+        // The reference takes the foot of a skeleton that breaks at a
+        // waypoint to be at the origin, and so does its gradient
+        if (!fkin_dual(link, target_waypoint.t, &foot)) {
+            foot = (dual_point){.x = dual_constant(0), .y = dual_constant(0)};
+        }
+
+        foot.y = dual_sub(foot.y, lowest_foot.y);
+
+        // Compute the distance between the foot and the target foot
+        dual dx = dual_sub(foot.x, dual_constant(target_waypoint.x));
+        dual dy = dual_sub(foot.y, dual_constant(target_waypoint.y));
+        dual squared_distance = dual_add(dual_mul(dx, dx), dual_mul(dy, dy));
+
+        // The distance has no gradient where the foot meets its target
+        if (squared_distance.value > 0) {
+            total_error = dual_add(total_error, dual_sqrt(squared_distance));
+        }
+    }
+
+    decimal mean_error = total_error.value / target_stride->length;
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        gradient[i] = -total_error.gradient[i] / target_stride->length;
+    }
+
+    return -mean_error;
+}
+
+/**
+ * @brief Compute the fitness of the linkage in the screening precision, bypassing the cache
+ */
+static decimal compute_screening_fitness(linkage link, const evaluator *eval) {
+    if (eval->screening == PRECISION_LONG_DOUBLE) {
+        return compute_reference_fitness(link, eval);
+    }
+
+    return compute_batch_fitness(link, eval, eval->stride_angles, eval->screening);
+}
+
+decimal compute_fitness(linkage link, const evaluator *eval) {
+    if (eval->cache == NULL) {
+        return compute_screening_fitness(link, eval);
+    }
+
+    decimal fitness;
+
+    if (!fitness_cache_lookup(eval->cache, &link, &fitness)) {
+        fitness = compute_screening_fitness(link, eval);
+        fitness_cache_store(eval->cache, &link, fitness);
+    }
+
+    return fitness;
+}
+
+void verify_individual(individual *specimen, evaluator *eval) {
+    if (specimen->verified) {
+        return;
+    }
+
+    uint64_t start = telemetry_now(eval->telemetry);
+    decimal fitness = compute_reference_fitness(specimen->genes, eval);
+    telemetry_record_evaluation(eval->telemetry, start);
 
-    for (size_t i = 0; i < population_size; i++) {
-        linkage genes;
-        decimal fitness;
-        
-        do {
-            genes = random_linkage();
-            fitness = compute_fitness(genes, target_stride, resolution);
-        } while (fitness == -INFINITY);
+    if ((fitness == -INFINITY) != (specimen->fitness == -INFINITY)) {
+        atomic_fetch_add_explicit(&eval->num_disagreements, 1, memory_order_relaxed);
+    }
+
+    atomic_fetch_add_explicit(&eval->num_verified, 1, memory_order_relaxed);
+
+    specimen->fitness = fitness;
+    specimen->verified = true;
+}
+
+/**
+ * @brief One in this many offspring that screen broken are re-evaluated in long double
+ */
+#define BROKEN_SAMPLE_INTERVAL 64
+
+/**
+ * @brief Re-evaluates a sample of the offspring that screened broken
+ *
+ * Verification only sees the individuals that screened unbroken, so it
+ * cannot count the linkages that only break in the screening precision.
+ * Every BROKEN_SAMPLE_INTERVAL-th broken child is re-evaluated in long
+ * double to count those. The child stays broken either way, so sampling
+ * does not change the run.
+ *
+ * @param child The linkage of the child
+ * @param fitness The screened fitness of the child
+ * @param index The index of the child, which decides whether it is sampled
+ * @param eval The evaluator
+ */
+static void sample_broken_offspring(linkage child, decimal fitness, size_t index, evaluator *eval) {
+    if (fitness != -INFINITY || eval->screening == PRECISION_LONG_DOUBLE || index % BROKEN_SAMPLE_INTERVAL != 0) {
+        return;
+    }
+
+    uint64_t start = telemetry_now(eval->telemetry);
+    decimal reference_fitness = compute_reference_fitness(child, eval);
+    telemetry_record_evaluation(eval->telemetry, start);
 
-        initial_population->individuals[i] = (individual){.genes = genes, .fitness = fitness};
+    if (reference_fitness != -INFINITY) {
+        atomic_fetch_add_explicit(&eval->num_broken_disagreements, 1, memory_order_relaxed);
     }
 
+    atomic_fetch_add_explicit(&eval->num_broken_sampled, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief The shared state of a parallel verification
+ */
+typedef struct verification_job {
+    population *pop;
+    evaluator *eval;
+} verification_job;
+
+/**
+ * @brief Verifies a single individual of a verification job
+ */
+static void verify_job_individual(void *context, size_t index) {
+    verification_job *job = context;
+    individual specimen = population_get(job->pop, index);
+    verify_individual(&specimen, job->eval);
+    population_set(job->pop, index, specimen);
+}
+
+/**
+ * @brief Verifies every individual of a population and drops the broken ones
+ *
+ * The order of the remaining individuals is preserved, and the size of the
+ * population is reduced accordingly.
+ */
+static void verify_population(population *pop, evaluator *eval, thread_pool *pool) {
+    verification_job job = {.pop = pop, .eval = eval};
+    pool_parallel_for(pool, pop->size, verify_job_individual, &job);
+
+    size_t num_unbroken = 0;
+
+    for (size_t i = 0; i < pop->size; i++) {
+        if (pop->fitness[i] != -INFINITY) {
+            population_copy_individual(pop, num_unbroken++, pop, i);
+        }
+    }
+
+    pop->size = num_unbroken;
+}
+
+individual get_verified_best_individual(population *pop, evaluator *eval) {
+    // Verifying the best individual can lower its fitness, in which case
+    // another individual may be the best now
+    while (true) {
+        size_t best_index = 0;
+
+        for (size_t i = 1; i < pop->size; i++) {
+            if (pop->fitness[i] > pop->fitness[best_index]) {
+                best_index = i;
+            }
+        }
+
+        individual best_individual = population_get(pop, best_index);
+
+        if (best_individual.verified) {
+            return best_individual;
+        }
+
+        verify_individual(&best_individual, eval);
+        population_set(pop, best_index, best_individual);
+    }
+}
+
+individual peek_verified_best_individual(const population *pop, evaluator *eval, generation_buffers *buffers) {
+    if (pop->size > buffers->next->capacity) {
+        fprintf(stderr, "Error: The population of %zu individuals does not fit in the buffers\n", pop->size);
+        exit(1);
+    }
+
+    // The verified fitnesses are written to a copy, which is free between
+    // two calls of the steady state
+    population_copy(buffers->next, pop);
+    return get_verified_best_individual(buffers->next, eval);
+}
+
+/**
+ * @brief The shared state of a parallel sampling of the initial population
+ */
+typedef struct sampling_job {
+    population *pop;
+    evaluator *eval;
+    uint64_t seed;
+} sampling_job;
+
+/**
+ * @brief Samples a single individual of the initial population
+ *
+ * Every individual draws from its own stream, which is derived from the
+ * seed of the job and the index of the individual. Thus, the outcome does
+ * not depend on which thread samples it, or in which order.
+ */
+static void sample_individual(void *context, size_t index) {
+    sampling_job *job = context;
+
+    rng stream;
+    rng_seed(&stream, job->seed, index);
+
+    linkage genes;
+    decimal fitness;
+
+    uint64_t start = telemetry_now(job->eval->telemetry);
+
+    do {
+        genes = random_linkage(&stream);
+        fitness = compute_fitness(genes, job->eval);
+        atomic_fetch_add_explicit(&job->eval->num_evaluations, 1, memory_order_relaxed);
+    } while (fitness == -INFINITY);
+
+    telemetry_record_evaluation(job->eval->telemetry, start);
+
+    job->pop->genes[index] = genes;
+    job->pop->fitness[index] = fitness;
+    job->pop->verified[index] = job->eval->screening == PRECISION_LONG_DOUBLE;
+}
+
+population *sample_initial_population(size_t population_size, evaluator *eval, rng *generator, thread_pool *pool) {
+    uint64_t start = telemetry_now(eval->telemetry);
+    population *initial_population = population_init(population_size);
+
+    sampling_job job = {
+        .pop = initial_population,
+        .eval = eval,
+        .seed = rng_next(generator),
+    };
+
+    pool_parallel_for(pool, population_size, sample_individual, &job);
+    telemetry_record_phase(eval->telemetry, PHASE_SAMPLING, start);
+
     return initial_population;
 }
 
+/**
+ * @brief Computes the fitness of a child, screening it at the coarse resolution first
+ *
+ * Children that break at the coarse resolution, or whose coarse fitness is
+ * more than the margin below the survivor cutoff, keep their coarse fitness.
+ * The others are evaluated at full resolution. The coarse crank angles are
+ * a subset of the full ones, so a child that breaks in the screen also
+ * breaks at full resolution. The cache only holds full-resolution
+ * fitnesses, and is not consulted before the screen, so that whether a
+ * child is refined does not depend on what the cache happens to hold.
+ *
+ * @param child The linkage of the child
+ * @param eval The evaluator
+ * @param cutoff The fitness of the weakest survivor
+ * @return The fitness of the child, or -INFINITY if it breaks
+ */
+static decimal compute_offspring_fitness(linkage child, evaluator *eval, decimal cutoff) {
+    atomic_fetch_add_explicit(&eval->num_evaluations, 1, memory_order_relaxed);
+
+    if (eval->coarse_angles == NULL) {
+        return compute_fitness(child, eval);
+    }
+
+    // The batch kernels solve long double precision in double precision
+    decimal coarse_fitness = compute_batch_fitness(child, eval, eval->coarse_angles, eval->screening);
+    atomic_fetch_add_explicit(&eval->num_screened, 1, memory_order_relaxed);
+
+    if (coarse_fitness < cutoff - eval->coarse_margin) {
+        return coarse_fitness;
+    }
+
+    decimal fitness = compute_fitness(child, eval);
+    atomic_fetch_add_explicit(&eval->num_refined, 1, memory_order_relaxed);
+
+    if ((coarse_fitness >= cutoff) != (fitness >= cutoff)) {
+        atomic_fetch_add_explicit(&eval->num_rank_changes, 1, memory_order_relaxed);
+    }
+
+    return fitness;
+}
+
+/**
+ * @brief The shared state of a parallel breeding of the offspring
+ */
+typedef struct breeding_job {
+    population *next;
+    size_t num_survivors;
+    evaluator *eval;
+    decimal cutoff;
+    decimal mutation_rate;
+    decimal crossover_rate;
+    decimal noise_scale;
+    bool noise_absolute;
+    uint64_t seed;
+} breeding_job;
+
+/**
+ * @brief Crosses two parents over and mutates the child
+ *
+ * @param stream The random number stream of the child
+ * @param parent_a The parent that the child starts as a copy of
+ * @param parent_b The parent that the crossed-over links come from
+ * @param crossover_rate The rate of crossover
+ * @param mutation_rate The rate of mutation
+ * @param noise_scale The scale of the noise added to mutated links
+ * @param noise_absolute Whether the noise is absolute or relative
+ * @return The child
+ */
+static linkage breed(rng *stream,
+                     const linkage *parent_a,
+                     const linkage *parent_b,
+                     decimal crossover_rate,
+                     decimal mutation_rate,
+                     decimal noise_scale,
+                     bool noise_absolute) {
+    linkage child = *parent_a;
+    decimal draws[NUM_LINKS];
+
+    // Perform crossover
+    if (crossover_rate > 0) {
+        rnd_fill(stream, draws, NUM_LINKS);
+
+        for (size_t j = 0; j < NUM_LINKS; j++) {
+            if (draws[j] < crossover_rate) {
+                child.lengths[j] = parent_b->lengths[j];
+            }
+        }
+    }
+
+    // Perform mutation
+    if (mutation_rate > 0) {
+        rnd_fill(stream, draws, NUM_LINKS);
+
+        for (size_t j = 0; j < NUM_LINKS; j++) {
+            if (draws[j] < mutation_rate) {
+                child.lengths[j] = mutate(stream, child.lengths[j], noise_scale, noise_absolute);
+            }
+        }
+    }
+
+    return child;
+}
+
+/**
+ * @brief Breeds and evaluates a single child
+ *
+ * Like sample_individual, every child draws from its own stream, so the
+ * offspring do not depend on the number of threads.
+ */
+static void breed_child(void *context, size_t index) {
+    breeding_job *job = context;
+    population *next = job->next;
+    size_t num_survivors = job->num_survivors;
+
+    rng stream;
+    rng_seed(&stream, job->seed, index);
+
+    // Sample two different parents
+    size_t parent_a_index = rng_below(&stream, num_survivors);
+    size_t parent_b_index = parent_a_index;
+
+    if (num_survivors > 1) {
+        parent_b_index = (parent_a_index + 1 + rng_below(&stream, num_survivors - 1)) % num_survivors;
+    }
+
+    linkage child = breed(&stream,
+                          &next->genes[parent_a_index],
+                          &next->genes[parent_b_index],
+                          job->crossover_rate,
+                          job->mutation_rate,
+                          job->noise_scale,
+                          job->noise_absolute);
+
+    // We allow the children to potentially break
+    uint64_t start = telemetry_now(job->eval->telemetry);
+    decimal fitness = compute_offspring_fitness(child, job->eval, job->cutoff);
+    telemetry_record_evaluation(job->eval->telemetry, start);
+    sample_broken_offspring(child, fitness, index, job->eval);
+    next->genes[num_survivors + index] = child;
+    next->fitness[num_survivors + index] = fitness;
+    next->verified[num_survivors + index] = job->eval->screening == PRECISION_LONG_DOUBLE;
+}
+
 void evolve_population(
     population *pop,
-    trajectory *target_stride,
+    evaluator *eval,
     size_t num_survivors,
     decimal mutation_rate,
     decimal crossover_rate,
     decimal noise_scale,
     bool noise_absolute,
     bool deterministic_survival,
-    size_t resolution
+    bool verify_survivors,
+    rng *generator,
+    thread_pool *pool,
+    generation_buffers *buffers
 ) {
-    // Select the survivors
-    population *survivors = deterministic_survival ? select_survivors_deterministic(pop, num_survivors) : select_survivors_stochastic(pop, num_survivors);
+    telemetry *t = eval->telemetry;
+
+    // Select the survivors into the front of the next generation
+    uint64_t start = telemetry_now(t);
+    population *next = select_survivors(pop, num_survivors, deterministic_survival, generator, buffers);
+    telemetry_record_phase(t, PHASE_SELECTION, start);
+
+    // Re-evaluate in long double the survivors that were only screened in a
+    // faster precision, so that no parent breaks at the reference precision
+    if (verify_survivors) {
+        start = telemetry_now(t);
+        verify_population(next, eval, pool);
+
+        // If every survivor breaks in long double, select the survivors
+        // again from the individuals that do not. Verifying the population
+        // in place drops the broken ones, but the population is only a
+        // buffer from here on.
+        if (next->size == 0) {
+            size_t population_size = pop->size;
+            verify_population(pop, eval, pool);
+            next = select_survivors(pop, num_survivors, deterministic_survival, generator, buffers);
+            pop->size = population_size;
+        }
+
+        telemetry_record_phase(t, PHASE_VERIFICATION, start);
+    }
+
+    if (next->size == 0) {
+        fprintf(stderr, "Error: Every individual of the population breaks\n");
+        exit(1);
+    }
 
     // Determine the number of survivors and offspring
-    num_survivors = survivors->size;
+    num_survivors = next->size;
     size_t num_offspring = pop->size - num_survivors;
 
-    // Preserve the surviving parents
+    // The weakest survivor is the bar that screened offspring are measured against
+    decimal cutoff = INFINITY;
+
     for (size_t i = 0; i < num_survivors; i++) {
-        pop->individuals[i] = survivors->individuals[i];
+        if (next->fitness[i] < cutoff) {
+            cutoff = next->fitness[i];
+        }
     }
 
-    for (size_t i = num_survivors; i < pop->size; i++) {
-        // Sample two different parents
-        size_t parent_a_index = rand() % num_survivors;
-        size_t parent_b_index = (parent_a_index + 1 + rand() % (num_survivors - 1)) % num_survivors;
+    // Breed and evaluate the offspring behind the surviving parents, which
+    // are only read while the offspring are written
+    breeding_job job = {
+        .next = next,
+        .num_survivors = num_survivors,
+        .eval = eval,
+        .cutoff = cutoff,
+        .mutation_rate = mutation_rate,
+        .crossover_rate = crossover_rate,
+        .noise_scale = noise_scale,
+        .noise_absolute = noise_absolute,
+        .seed = rng_next(generator),
+    };
 
-        individual parent_a = survivors->individuals[parent_a_index];
-        individual parent_b = survivors->individuals[parent_b_index];
+    start = telemetry_now(t);
+    pool_parallel_for(pool, num_offspring, breed_child, &job);
+    telemetry_record_phase(t, PHASE_BREEDING, start);
 
-        linkage child = parent_a.genes;
+    // The next generation takes the place of the current one
+    next->size = pop->size;
+    population_swap(pop, next);
+}
 
-        // Perform crossover
-        if (crossover_rate > 0) {
-            for (size_t j = 0; j < NUM_LINKS; j++) {
-                if (rnd() < crossover_rate) {
-                    child.lengths[j] = parent_b.genes.lengths[j];
-                }
+bool replacement_policy_parse(const char *name, replacement_policy *replacement) {
+    if (strcmp(name, "generational") == 0) {
+        *replacement = REPLACEMENT_GENERATIONAL;
+    } else if (strcmp(name, "worst") == 0) {
+        *replacement = REPLACEMENT_WORST;
+    } else if (strcmp(name, "tournament") == 0) {
+        *replacement = REPLACEMENT_TOURNAMENT;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief The number of individuals drawn for a replacement tournament
+ */
+#define REPLACEMENT_TOURNAMENT_SIZE 4
+
+/**
+ * @brief The number of individuals drawn for the tournament of a parent
+ *
+ * The winner is on average in the top fifth of the population, which is
+ * close to the parents of a generation with a quarter of survivors.
+ */
+#define PARENT_TOURNAMENT_SIZE 4
+
+/**
+ * @brief The shared state of a steady-state evolution
+ *
+ * The population, the heap and the counter are guarded by the lock, which
+ * is only held to hold the parent tournaments, copy the parents and insert
+ * a child. The random draws, breeding, evaluation and verification all
+ * happen without it.
+ */
+typedef struct steady_state_job {
+    population *pop;
+    evaluator *eval;
+    replacement_policy replacement;
+    decimal mutation_rate;
+    decimal crossover_rate;
+    decimal noise_scale;
+    bool noise_absolute;
+    bool verify_parents;
+    uint64_t seed;
+    size_t first_child;
+
+    pthread_mutex_t lock;
+    size_t *heap;
+    size_t *heap_positions;
+    size_t num_inserted;
+} steady_state_job;
+
+/**
+ * @brief Swaps two entries of the heap of a steady-state job
+ */
+static inline void heap_swap(steady_state_job *job, size_t a, size_t b) {
+    size_t temporary = job->heap[a];
+    job->heap[a] = job->heap[b];
+    job->heap[b] = temporary;
+    job->heap_positions[job->heap[a]] = a;
+    job->heap_positions[job->heap[b]] = b;
+}
+
+/**
+ * @brief Checks if an individual is weaker than another in the heap of a steady-state job
+ *
+ * Individuals with the same fitness are ordered by index, so that the
+ * weakest individual does not depend on how the heap was built.
+ */
+static inline bool heap_weaker(const steady_state_job *job, size_t a, size_t b) {
+    const decimal *fitness = job->pop->fitness;
+    return fitness[a] < fitness[b] || (fitness[a] == fitness[b] && a < b);
+}
+
+/**
+ * @brief Moves an entry of the heap down until both of its children are fitter
+ */
+static void heap_sift_down(steady_state_job *job, size_t position) {
+    size_t size = job->pop->size;
+
+    while (true) {
+        size_t weakest = position;
+        size_t left = 2 * position + 1;
+        size_t right = left + 1;
+
+        if (left < size && heap_weaker(job, job->heap[left], job->heap[weakest])) {
+            weakest = left;
+        }
+
+        if (right < size && heap_weaker(job, job->heap[right], job->heap[weakest])) {
+            weakest = right;
+        }
+
+        if (weakest == position) {
+            return;
+        }
+
+        heap_swap(job, position, weakest);
+        position = weakest;
+    }
+}
+
+/**
+ * @brief Restores the heap after the fitness of an individual changed
+ *
+ * @param job The steady-state job
+ * @param index The index of the individual in the population
+ */
+static void heap_update(steady_state_job *job, size_t index) {
+    size_t position = job->heap_positions[index];
+
+    // Move the entry up while it is weaker than its parent
+    while (position > 0 && heap_weaker(job, job->heap[position], job->heap[(position - 1) / 2])) {
+        heap_swap(job, position, (position - 1) / 2);
+        position = (position - 1) / 2;
+    }
+
+    heap_sift_down(job, position);
+}
+
+/**
+ * @brief The random draws of the parent tournaments of a child
+ *
+ * The draws are made before the population is locked. The contestants of
+ * the second parent are offsets past the first parent, which is only known
+ * once its tournament is held under the lock.
+ */
+typedef struct parent_draws {
+    size_t contestants[PARENT_TOURNAMENT_SIZE];
+    size_t offsets[PARENT_TOURNAMENT_SIZE];
+} parent_draws;
+
+/**
+ * @brief Draws the contestants of the parent tournaments of a child
+ */
+static void draw_parents(rng *stream, size_t n, parent_draws *draws) {
+    for (size_t i = 0; i < PARENT_TOURNAMENT_SIZE; i++) {
+        draws->contestants[i] = rng_below(stream, n);
+        draws->offsets[i] = n > 1 ? rng_below(stream, n - 1) : 0;
+    }
+}
+
+/**
+ * @brief Holds a parent tournament, avoiding one index
+ *
+ * The lock must be held by the caller.
+ *
+ * @param pop The population
+ * @param draws The draws of the tournaments
+ * @param excluded The index of the individual not to pick, or SIZE_MAX to
+ *                 hold the tournament of the first parent
+ * @return The index of the fittest contestant
+ */
+static size_t pick_parent(const population *pop, const parent_draws *draws, size_t excluded) {
+    size_t n = pop->size;
+    size_t winner = SIZE_MAX;
+
+    for (size_t i = 0; i < PARENT_TOURNAMENT_SIZE; i++) {
+        size_t contestant = draws->contestants[i];
+
+        if (excluded < n && n > 1) {
+            contestant = (excluded + 1 + draws->offsets[i]) % n;
+        }
+
+        if (winner == SIZE_MAX || pop->fitness[contestant] > pop->fitness[winner]) {
+            winner = contestant;
+        }
+    }
+
+    return winner;
+}
+
+/**
+ * @brief Gets the genes of a parent, verifying it first
+ *
+ * Like the survivors of a generation, a parent that was only screened is
+ * re-evaluated in long double before it breeds, unless parents are not
+ * verified. The lock is released while the parent is verified, and its
+ * verified fitness is written back if it is still in the population by
+ * then.
+ *
+ * The lock must be held by the caller.
+ *
+ * @param job The steady-state job
+ * @param index The index of the parent in the population
+ * @param genes The genes of the parent
+ * @return false if the parent breaks in long double
+ */
+static bool get_verified_parent(steady_state_job *job, size_t index, linkage *genes) {
+    population *pop = job->pop;
+    individual parent = population_get(pop, index);
+
+    if (job->verify_parents && !parent.verified) {
+        pthread_mutex_unlock(&job->lock);
+        verify_individual(&parent, job->eval);
+        pthread_mutex_lock(&job->lock);
+
+        // Another thread may have replaced or verified the parent meanwhile
+        if (!pop->verified[index] && linkage_equals(pop->genes[index], parent.genes)) {
+            pop->fitness[index] = parent.fitness;
+            pop->verified[index] = true;
+
+            if (job->replacement == REPLACEMENT_WORST) {
+                heap_update(job, index);
             }
         }
+    }
 
-        // Perform mutation
-        if (mutation_rate > 0) {
-            for (size_t j = 0; j < NUM_LINKS; j++) {
-                if (rnd() < mutation_rate) {
-                    child.lengths[j] = mutate(child.lengths[j], noise_scale, noise_absolute);
-                }
+    *genes = parent.genes;
+
+    return parent.fitness != -INFINITY;
+}
+
+/**
+ * @brief Breeds, evaluates and inserts a single child of a steady-state evolution
+ *
+ * The parents are drawn by tournaments from the population as it is when
+ * the child is bred, which already contains the children that were
+ * inserted before. If a parent breaks in long double, the child is not
+ * bred, and the parent is left to be replaced.
+ */
+static void steady_state_child(void *context, size_t index) {
+    steady_state_job *job = context;
+    population *pop = job->pop;
+
+    // Children are numbered across the whole run, so that their streams do
+    // not depend on how the run splits them into calls
+    size_t number = job->first_child + index;
+
+    rng stream;
+    rng_seed(&stream, job->seed, number);
+
+    // Draw the individuals that the child would replace in a tournament,
+    // and the contestants for its parents, before the population is locked
+    size_t contestants[REPLACEMENT_TOURNAMENT_SIZE];
+
+    if (job->replacement == REPLACEMENT_TOURNAMENT) {
+        for (size_t i = 0; i < REPLACEMENT_TOURNAMENT_SIZE; i++) {
+            contestants[i] = rng_below(&stream, pop->size);
+        }
+    }
+
+    parent_draws draws;
+    draw_parents(&stream, pop->size, &draws);
+
+    // Copy the parents, and the fitness that the child has to beat
+    pthread_mutex_lock(&job->lock);
+
+    linkage parent_a;
+    linkage parent_b;
+    size_t parent_a_index = pick_parent(pop, &draws, SIZE_MAX);
+
+    if (!get_verified_parent(job, parent_a_index, &parent_a) ||
+        !get_verified_parent(job, pick_parent(pop, &draws, parent_a_index), &parent_b)) {
+        pthread_mutex_unlock(&job->lock);
+        return;
+    }
+
+    decimal cutoff = INFINITY;
+
+    if (job->replacement == REPLACEMENT_WORST) {
+        cutoff = pop->fitness[job->heap[0]];
+    } else {
+        for (size_t i = 0; i < REPLACEMENT_TOURNAMENT_SIZE; i++) {
+            if (pop->fitness[contestants[i]] < cutoff) {
+                cutoff = pop->fitness[contestants[i]];
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&job->lock);
+
+    linkage child = breed(&stream, &parent_a, &parent_b, job->crossover_rate, job->mutation_rate, job->noise_scale, job->noise_absolute);
+
+    uint64_t start = telemetry_now(job->eval->telemetry);
+    decimal fitness = compute_offspring_fitness(child, job->eval, cutoff);
+    telemetry_record_evaluation(job->eval->telemetry, start);
+    sample_broken_offspring(child, fitness, number, job->eval);
+
+    if (fitness <= cutoff) {
+        return;
+    }
+
+    individual specimen = {
+        .genes = child,
+        .fitness = fitness,
+        .verified = job->eval->screening == PRECISION_LONG_DOUBLE,
+    };
+
+    // Replace the weakest individual, if the child is still fitter than it
+    pthread_mutex_lock(&job->lock);
+
+    if (job->replacement == REPLACEMENT_WORST) {
+        size_t weakest = job->heap[0];
+
+        if (specimen.fitness > pop->fitness[weakest]) {
+            population_set(pop, weakest, specimen);
+            heap_sift_down(job, 0);
+            job->num_inserted++;
+        }
+    } else {
+        size_t weakest = contestants[0];
+
+        for (size_t i = 1; i < REPLACEMENT_TOURNAMENT_SIZE; i++) {
+            if (pop->fitness[contestants[i]] < pop->fitness[weakest]) {
+                weakest = contestants[i];
             }
         }
 
-        // We allow the children to potentially break
-        decimal fitness = compute_fitness(child, target_stride, resolution);
-        pop->individuals[i] = (individual){.genes = child, .fitness = fitness};
+        if (specimen.fitness > pop->fitness[weakest]) {
+            population_set(pop, weakest, specimen);
+            job->num_inserted++;
+        }
+    }
+
+    pthread_mutex_unlock(&job->lock);
+}
+
+size_t evolve_population_steady_state(
+    population *pop,
+    evaluator *eval,
+    size_t num_offspring,
+    decimal mutation_rate,
+    decimal crossover_rate,
+    decimal noise_scale,
+    bool noise_absolute,
+    replacement_policy replacement,
+    bool verify_parents,
+    uint64_t seed,
+    size_t first_child,
+    thread_pool *pool,
+    generation_buffers *buffers
+) {
+    if (pop->size > buffers->next->capacity) {
+        fprintf(stderr, "Error: The population of %zu individuals does not fit in the buffers\n", pop->size);
+        exit(1);
+    }
+
+    steady_state_job job = {
+        .pop = pop,
+        .eval = eval,
+        .replacement = replacement,
+        .mutation_rate = mutation_rate,
+        .crossover_rate = crossover_rate,
+        .noise_scale = noise_scale,
+        .noise_absolute = noise_absolute,
+        .verify_parents = verify_parents,
+        .seed = seed,
+        .first_child = first_child,
+        .heap = buffers->heap,
+        .heap_positions = buffers->heap_positions,
+        .num_inserted = 0,
+    };
+
+    if (pop->size == 0) {
+        return 0;
+    }
+
+    // The population may have changed since the last call, through
+    // migration or verification, so the heap is built anew. Its order is
+    // total, so this finds the same weakest individual as the last call
+    if (replacement == REPLACEMENT_WORST) {
+        for (size_t i = 0; i < pop->size; i++) {
+            job.heap[i] = i;
+            job.heap_positions[i] = i;
+        }
+
+        for (size_t i = pop->size / 2; i-- > 0;) {
+            heap_sift_down(&job, i);
+        }
     }
 
-    free(survivors);
-}
\ No newline at end of file
+    pthread_mutex_init(&job.lock, NULL);
+
+    uint64_t start = telemetry_now(eval->telemetry);
+    pool_parallel_for(pool, num_offspring, steady_state_child, &job);
+    telemetry_record_phase(eval->telemetry, PHASE_BREEDING, start);
+
+    pthread_mutex_destroy(&job.lock);
+
+    return job.num_inserted;
+}
@@ -0,0 +1,65 @@
+#include <stdlib.h>
+
+#include "utils.h"
+#include "decimal.h"
+#include "fft.h"
+
+bool fft_supports(size_t n) {
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+fft_complex *fft_twiddles(size_t n) {
+    size_t count = n / 2 > 0 ? n / 2 : 1;
+    fft_complex *twiddles = malloc(count * sizeof(fft_complex));
+    check_memory(twiddles);
+
+    for (size_t k = 0; k < n / 2; k++) {
+        decimal angle = -2 * M_PI * k / n;
+        twiddles[k] = (fft_complex){.re = cos(angle), .im = sin(angle)};
+    }
+
+    return twiddles;
+}
+
+void fft(fft_complex *signal, size_t n, const fft_complex *twiddles, bool inverse) {
+    // Put the signal in bit-reversed order
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+
+        j ^= bit;
+
+        if (i < j) {
+            fft_complex swap = signal[i];
+            signal[i] = signal[j];
+            signal[j] = swap;
+        }
+    }
+
+    // Combine the transforms of the halves, doubling their length each pass
+    for (size_t length = 2; length <= n; length <<= 1) {
+        size_t half = length / 2;
+        size_t stride = n / length;
+
+        for (size_t start = 0; start < n; start += length) {
+            for (size_t k = 0; k < half; k++) {
+                fft_complex w = twiddles[k * stride];
+                w.im = inverse ? -w.im : w.im;
+
+                fft_complex u = signal[start + k];
+                fft_complex v = signal[start + k + half];
+                fft_complex t = (fft_complex){.re = v.re * w.re - v.im * w.im, .im = v.re * w.im + v.im * w.re};
+
+                signal[start + k] = (fft_complex){.re = u.re + t.re, .im = u.im + t.im};
+                signal[start + k + half] = (fft_complex){.re = u.re - t.re, .im = u.im - t.im};
+            }
+        }
+    }
+}
+
+fft_complex fft_multiply_conjugate(fft_complex a, fft_complex b) {
+    return (fft_complex){.re = a.re * b.re + a.im * b.im, .im = a.im * b.re - a.re * b.im};
+}
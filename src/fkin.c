@@ -4,6 +4,38 @@
 #include "path.h"
 #include "geometry.h"
 
+/**
+ * @brief Checks if a solved skeleton is broken
+ *
+ * A skeleton breaks if any joint is below the foot, or if any two of its
+ * segments cross.
+ */
+static bool skeleton_breaks(const skeleton *skel) {
+    decimal foot_y = skel->joints[NUM_JOINTS - 1].y;
+
+    // Check if any joints are below the foot point
+    for (size_t joint = 0; joint < NUM_JOINTS - 1; joint++) {
+        if (skel->joints[joint].y < foot_y) {
+            return true;
+        }
+    }
+
+    // Check the pairs of segments that can cross, most likely first
+    for (size_t pair = 0; pair < NUM_CROSSING_PAIRS; pair++) {
+        const size_t *s1 = SEGMENT_JOINTS[CROSSING_PAIRS[pair][0]];
+        const size_t *s2 = SEGMENT_JOINTS[CROSSING_PAIRS[pair][1]];
+
+        segment first = (segment){.start = skel->joints[s1[0]], .end = skel->joints[s1[1]]};
+        segment second = (segment){.start = skel->joints[s2[0]], .end = skel->joints[s2[1]]};
+
+        if (segments_intersect(first, second)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 skeleton fkin(linkage link, decimal theta) {
     // Get the link lengths and give them each a name
     decimal a = link.lengths[0];
@@ -97,50 +129,6 @@ skeleton fkin(linkage link, decimal theta) {
     decimal Gx = Ex + i * cos(epsilon + zeta + eta);
     decimal Gy = Ey + i * sin(epsilon + zeta + eta);
 
-    // Check if any joints are below the foot point
-    if (Ay < Gy || By < Gy || Cy < Gy || Dy < Gy || Ey < Gy || Fy < Gy) {
-        return BROKEN_SKELETON;
-    }
-
-    point A = (point){.x = Ax, .y = Ay};
-    point B = (point){.x = Bx, .y = By};
-    point C = (point){.x = Cx, .y = Cy};
-    point D = (point){.x = Dx, .y = Dy};
-    point E = (point){.x = Ex, .y = Ey};
-    point F = (point){.x = Fx, .y = Fy};
-    point G = (point){.x = Gx, .y = Gy};
-
-    segment AC = (segment){.start = A, .end = C};
-    segment AE = (segment){.start = A, .end = E};
-    segment BC = (segment){.start = B, .end = C};
-    segment BD = (segment){.start = B, .end = D};
-    segment BE = (segment){.start = B, .end = E};
-    segment CD = (segment){.start = C, .end = D};
-    segment DF = (segment){.start = D, .end = F};
-    segment EF = (segment){.start = E, .end = F};
-    segment EG = (segment){.start = E, .end = G};
-    segment FG = (segment){.start = F, .end = G};
-
-    segment segments[] = {AC, AE, BC, BD, BE, CD, DF, EF, EG, FG};
-
-    for (size_t i = 0; i < 9; i++) {
-        for (size_t j = i + 1; j < 10; j++) {
-            point p1 = segments[i].start;
-            point p2 = segments[i].end;
-            point p3 = segments[j].start;
-            point p4 = segments[j].end;
-
-            if (point_equals(p1, p3)) { continue; }
-            if (point_equals(p1, p4)) { continue; }
-            if (point_equals(p2, p3)) { continue; }
-            if (point_equals(p2, p4)) { continue; }
-
-            if (segments_intersect(segments[i], segments[j])) {
-                return BROKEN_SKELETON;
-            }
-        }
-    }
-
     skeleton skel = (skeleton){.broken = false};
 
     skel.joints[0] = (point){Ax, Ay};
@@ -151,23 +139,159 @@ skeleton fkin(linkage link, decimal theta) {
     skel.joints[5] = (point){Fx, Fy};
     skel.joints[6] = (point){Gx, Gy};
 
+    if (skeleton_breaks(&skel)) {
+        return BROKEN_SKELETON;
+    }
+
     return skel;
 }
 
-path *compute_stride(linkage link, size_t resolution) {
-    path *p = path_init(resolution);
+bool fkin_dual(linkage link, decimal theta, dual_point *foot) {
+    // Every link length is a variable
+    dual a = dual_variable(link.lengths[0], 0);
+    dual b = dual_variable(link.lengths[1], 1);
+    dual c = dual_variable(link.lengths[2], 2);
+    dual d = dual_variable(link.lengths[3], 3);
+    dual e = dual_variable(link.lengths[4], 4);
+    dual f = dual_variable(link.lengths[5], 5);
+    dual g = dual_variable(link.lengths[6], 6);
+    dual h = dual_variable(link.lengths[7], 7);
+    dual i = dual_variable(link.lengths[8], 8);
+    dual j = dual_variable(link.lengths[9], 9);
+    dual k = dual_variable(link.lengths[10], 10);
+    dual l = dual_variable(link.lengths[11], 11);
+    dual m = dual_variable(link.lengths[12], 12);
+
+    // The same steps as fkin, in the same order, so that the values agree
+    dual Ax = dual_scale(m, cos(theta));
+    dual Ay = dual_scale(m, sin(theta));
+
+    dual Bx = dual_negate(a);
+    dual By = dual_negate(l);
+
+    dual dABx = dual_sub(Ax, Bx);
+    dual dABy = dual_sub(Ay, By);
+
+    dual AB2 = dual_add(dual_mul(dABx, dABx), dual_mul(dABy, dABy));
+    dual AB = dual_sqrt(AB2);
+
+    dual alpha = dual_atan2(dABy, dABx);
+
+    dual cosBeta = dual_div(dual_sub(dual_add(AB2, dual_mul(b, b)), dual_mul(j, j)), dual_mul(dual_scale(AB, 2), b));
+
+    if (abs(cosBeta.value) > 1) {
+        return false;
+    }
+
+    dual beta = dual_acos(cosBeta);
+
+    dual Cx = dual_add(Bx, dual_mul(b, dual_cos(dual_add(alpha, beta))));
+    dual Cy = dual_add(By, dual_mul(b, dual_sin(dual_add(alpha, beta))));
+
+    dual cosGamma = dual_div(dual_sub(dual_add(dual_mul(b, b), dual_mul(d, d)), dual_mul(e, e)), dual_mul(dual_scale(b, 2), d));
+
+    if (abs(cosGamma.value) > 1) {
+        return false;
+    }
+
+    dual gamma = dual_acos(cosGamma);
+
+    dual cosDelta = dual_div(dual_sub(dual_add(AB2, dual_mul(c, c)), dual_mul(k, k)), dual_mul(dual_scale(AB, 2), c));
+
+    if (abs(cosDelta.value) > 1) {
+        return false;
+    }
+
+    dual delta = dual_acos(cosDelta);
 
-    for (size_t step = 0; step < resolution; step++) {
-        decimal crank_angle = 2 * M_PI * step / resolution;
-        skeleton skel = fkin(link, crank_angle);
+    dual Dx = dual_add(Bx, dual_mul(d, dual_cos(dual_add(dual_add(alpha, beta), gamma))));
+    dual Dy = dual_add(By, dual_mul(d, dual_sin(dual_add(dual_add(alpha, beta), gamma))));
 
-        if (skel.broken) {
-            free(p);
-            return NULL;
+    dual Ex = dual_add(Bx, dual_mul(c, dual_cos(dual_sub(alpha, delta))));
+    dual Ey = dual_add(By, dual_mul(c, dual_sin(dual_sub(alpha, delta))));
+
+    dual dDEx = dual_sub(Dx, Ex);
+    dual dDEy = dual_sub(Dy, Ey);
+
+    dual DE2 = dual_add(dual_mul(dDEx, dDEx), dual_mul(dDEy, dDEy));
+    dual DE = dual_sqrt(DE2);
+
+    dual epsilon = dual_atan2(dDEy, dDEx);
+
+    dual cosZeta = dual_div(dual_sub(dual_add(DE2, dual_mul(g, g)), dual_mul(f, f)), dual_mul(dual_scale(DE, 2), g));
+
+    if (abs(cosZeta.value) > 1) {
+        return false;
+    }
+
+    dual zeta = dual_acos(cosZeta);
+
+    dual cosEta = dual_div(dual_sub(dual_add(dual_mul(g, g), dual_mul(i, i)), dual_mul(h, h)), dual_mul(dual_scale(g, 2), i));
+
+    if (abs(cosEta.value) > 1) {
+        return false;
+    }
+
+    dual eta = dual_acos(cosEta);
+
+    dual Fx = dual_add(Ex, dual_mul(g, dual_cos(dual_add(epsilon, zeta))));
+    dual Fy = dual_add(Ey, dual_mul(g, dual_sin(dual_add(epsilon, zeta))));
+
+    dual Gx = dual_add(Ex, dual_mul(i, dual_cos(dual_add(dual_add(epsilon, zeta), eta))));
+    dual Gy = dual_add(Ey, dual_mul(i, dual_sin(dual_add(dual_add(epsilon, zeta), eta))));
+
+    skeleton skel = (skeleton){.broken = false};
+
+    skel.joints[0] = (point){Ax.value, Ay.value};
+    skel.joints[1] = (point){Bx.value, By.value};
+    skel.joints[2] = (point){Cx.value, Cy.value};
+    skel.joints[3] = (point){Dx.value, Dy.value};
+    skel.joints[4] = (point){Ex.value, Ey.value};
+    skel.joints[5] = (point){Fx.value, Fy.value};
+    skel.joints[6] = (point){Gx.value, Gy.value};
+
+    if (skeleton_breaks(&skel)) {
+        return false;
+    }
+
+    *foot = (dual_point){.x = Gx, .y = Gy};
+    return true;
+}
+
+bool compute_stride(linkage link, const crank_table *crank, fkin_backend backend, path *stride) {
+    prepared_linkage prepared;
+
+    if (!linkage_prepare(link, &prepared)) {
+        return false;
+    }
+
+    size_t resolution = crank->length;
+
+    linkage_batch batch;
+    skeleton_batch skel;
+
+    for (size_t lane = 0; lane < FKIN_BATCH_SIZE; lane++) {
+        linkage_batch_set(&batch, lane, &prepared, crank->angles[0]);
+    }
+
+    for (size_t start = 0; start < resolution; start += FKIN_BATCH_SIZE) {
+        // Solve a batch of consecutive crank angles. If the resolution is not
+        // a multiple of the batch size, the last angle fills the spare lanes.
+        for (size_t lane = 0; lane < FKIN_BATCH_SIZE; lane++) {
+            size_t step = start + lane < resolution ? start + lane : resolution - 1;
+            linkage_batch_set_angle(&batch, lane, crank->angles[step]);
         }
 
-        p->points[step] = skeleton_get_foot(skel);
+        fkin_batch(&batch, &skel, backend, PRECISION_DOUBLE);
+
+        for (size_t lane = 0; lane < FKIN_BATCH_SIZE && start + lane < resolution; lane++) {
+            if (skel.broken[lane]) {
+                return false;
+            }
+
+            stride->points[start + lane] = (point){.x = skel.x[NUM_JOINTS - 1][lane], .y = skel.y[NUM_JOINTS - 1][lane]};
+        }
     }
 
-    return p;
-}
\ No newline at end of file
+    return true;
+}
@@ -0,0 +1,103 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "fkin_batch.h"
+
+// The batch kernels work in single or double precision, regardless of the
+// precision selected in decimal.h, so use the plain libm functions.
+#undef sin
+#undef cos
+#undef acos
+#undef atan2
+#undef sqrt
+
+void linkage_batch_set(linkage_batch *batch, size_t lane, const prepared_linkage *link, crank_angle angle) {
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        batch->lengths[i][lane] = link->lengths[i];
+        batch->squared[i][lane] = link->squared[i];
+    }
+
+    batch->gamma[lane] = link->gamma;
+    batch->eta[lane] = link->eta;
+    batch->cos_gamma[lane] = link->cos_gamma;
+    batch->sin_gamma[lane] = link->sin_gamma;
+    batch->cos_eta[lane] = link->cos_eta;
+    batch->sin_eta[lane] = link->sin_eta;
+    linkage_batch_set_angle(batch, lane, angle);
+}
+
+// Instantiate the kernels in double precision
+#define REAL double
+#define MASK int64_t
+#define KERNEL(name) name##_double
+#define REAL_SIN sin
+#define REAL_COS cos
+#define REAL_ACOS acos
+#define REAL_ATAN2 atan2
+#define REAL_SQRT sqrt
+#define REAL_FABS fabs
+#include "fkin_kernel.inc"
+#undef REAL
+#undef MASK
+#undef KERNEL
+#undef REAL_SIN
+#undef REAL_COS
+#undef REAL_ACOS
+#undef REAL_ATAN2
+#undef REAL_SQRT
+#undef REAL_FABS
+
+// Instantiate the kernels in single precision
+#define REAL float
+#define MASK int32_t
+#define KERNEL(name) name##_float
+#define REAL_SIN sinf
+#define REAL_COS cosf
+#define REAL_ACOS acosf
+#define REAL_ATAN2 atan2f
+#define REAL_SQRT sqrtf
+#define REAL_FABS fabsf
+#include "fkin_kernel.inc"
+#undef REAL
+#undef MASK
+#undef KERNEL
+#undef REAL_SIN
+#undef REAL_COS
+#undef REAL_ACOS
+#undef REAL_ATAN2
+#undef REAL_SQRT
+#undef REAL_FABS
+
+void fkin_batch(const linkage_batch *in, skeleton_batch *out, fkin_backend backend, precision prec) {
+    if (prec == PRECISION_FLOAT) {
+        fkin_batch_float(in, out, backend);
+    } else {
+        fkin_batch_double(in, out, backend);
+    }
+}
+
+bool fkin_backend_parse(const char *name, fkin_backend *backend) {
+    if (strcmp(name, "trig") == 0) {
+        *backend = FKIN_TRIGONOMETRIC;
+    } else if (strcmp(name, "algebraic") == 0) {
+        *backend = FKIN_ALGEBRAIC;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+bool precision_parse(const char *name, precision *prec) {
+    if (strcmp(name, "float") == 0) {
+        *prec = PRECISION_FLOAT;
+    } else if (strcmp(name, "double") == 0) {
+        *prec = PRECISION_DOUBLE;
+    } else if (strcmp(name, "long") == 0) {
+        *prec = PRECISION_LONG_DOUBLE;
+    } else {
+        return false;
+    }
+
+    return true;
+}
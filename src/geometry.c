@@ -8,7 +8,7 @@
  * @param C The point to check
  * @return true if the point C is on the left side of the line AB
  */
-static decimal ccw(point A, point B, point C) {
+static bool ccw(point A, point B, point C) {
     return (C.y - A.y) * (B.x - A.x) > (B.y - A.y) * (C.x - A.x); 
 }
 
@@ -25,5 +25,7 @@ bool segments_intersect(segment s1, segment s2) {
     point C = s2.start;
     point D = s2.end;
 
-    return ccw(A, C, D) != ccw(B, C, D) && ccw(A, B, C) != ccw(A, B, D);
+    // Combine the four orientations with bitwise operators rather than
+    // short-circuiting, so the test compiles to straight-line code
+    return (ccw(A, C, D) ^ ccw(B, C, D)) & (ccw(A, B, C) ^ ccw(A, B, D));
 }
\ No newline at end of file
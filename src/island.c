@@ -0,0 +1,348 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "utils.h"
+#include "evolution.h"
+#include "island.h"
+
+/**
+ * @brief The migrants published by an island
+ *
+ * @param lock Guards the rest of the outbox across processes
+ * @param epoch The number of times the island has published emigrants
+ * @param best The best individual found by the island so far
+ * @param num_emigrants The number of emigrants
+ * @param emigrants The best individuals of the island when it last published
+ */
+typedef struct outbox {
+    pthread_mutex_t lock;
+    uint64_t epoch;
+    individual best;
+    size_t num_emigrants;
+    individual emigrants[];
+} outbox;
+
+/**
+ * @brief The fitness of an individual together with its index in the population
+ */
+typedef struct ranked_fitness {
+    decimal fitness;
+    size_t index;
+} ranked_fitness;
+
+/**
+ * The header of the shared memory, which is followed by the epochs that
+ * every island last collected from every other island, and then by the
+ * outboxes.
+ *
+ * The migrants and ranks buffers are allocated on the heap before the
+ * islands are forked, so every island gets its own private copy at the
+ * same address.
+ */
+struct archipelago {
+    size_t num_islands;
+    size_t migration_size;
+    size_t population_size;
+    individual *migrants;
+    ranked_fitness *ranked;
+    migration_topology topology;
+    pid_t founder;
+    size_t mapping_size;
+    size_t collected_offset;
+    size_t outbox_offset;
+    size_t outbox_size;
+};
+
+/**
+ * @brief Rounds a size up so that whatever follows it is suitably aligned
+ */
+static size_t align_size(size_t size) {
+    size_t alignment = _Alignof(max_align_t);
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @brief Gets the outbox of an island
+ */
+static outbox *get_outbox(const archipelago *islands, size_t island) {
+    return (outbox *)((char *)islands + islands->outbox_offset + island * islands->outbox_size);
+}
+
+/**
+ * @brief Gets the epoch of a sender that an island last collected
+ */
+static uint64_t *get_collected(const archipelago *islands, size_t receiver, size_t sender) {
+    uint64_t *collected = (uint64_t *)((char *)islands + islands->collected_offset);
+    return &collected[receiver * islands->num_islands + sender];
+}
+
+archipelago *archipelago_init(size_t num_islands, size_t migration_size, size_t population_size, migration_topology topology) {
+    size_t collected_offset = align_size(sizeof(archipelago));
+    size_t outbox_offset = collected_offset + align_size(num_islands * num_islands * sizeof(uint64_t));
+    size_t outbox_size = align_size(sizeof(outbox) + migration_size * sizeof(individual));
+    size_t mapping_size = outbox_offset + num_islands * outbox_size;
+
+    // The name is only needed until the memory is mapped, and unlinking it
+    // right away ensures that nothing is left behind, however the run ends
+    char name[64];
+    snprintf(name, sizeof(name), "/strandbeest-%ld", (long)getpid());
+
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not create shared memory %s\n", name);
+        exit(1);
+    }
+
+    shm_unlink(name);
+
+    if (ftruncate(fd, mapping_size) != 0) {
+        fprintf(stderr, "Error: Could not allocate %zu bytes of shared memory\n", mapping_size);
+        exit(1);
+    }
+
+    void *memory = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (memory == MAP_FAILED) {
+        fprintf(stderr, "Error: Could not map shared memory\n");
+        exit(1);
+    }
+
+    // The memory starts zeroed, so no island has published or collected
+    // anything yet
+    archipelago *islands = memory;
+    islands->num_islands = num_islands;
+    islands->migration_size = migration_size;
+    islands->migrants = malloc((migration_size > 0 ? migration_size : 1) * sizeof(individual));
+    check_memory(islands->migrants);
+    islands->population_size = population_size;
+    islands->ranked = malloc((population_size > 0 ? population_size : 1) * sizeof(ranked_fitness));
+    check_memory(islands->ranked);
+    islands->topology = topology;
+    islands->founder = getpid();
+    islands->mapping_size = mapping_size;
+    islands->collected_offset = collected_offset;
+    islands->outbox_offset = outbox_offset;
+    islands->outbox_size = outbox_size;
+
+    pthread_mutexattr_t attributes;
+    pthread_mutexattr_init(&attributes);
+    pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+
+    for (size_t island = 0; island < num_islands; island++) {
+        outbox *box = get_outbox(islands, island);
+        pthread_mutex_init(&box->lock, &attributes);
+        box->best.fitness = -INFINITY;
+    }
+
+    pthread_mutexattr_destroy(&attributes);
+
+    return islands;
+}
+
+size_t archipelago_fork(archipelago *islands) {
+    // Buffered output would otherwise be written once by every process
+    fflush(NULL);
+
+    for (size_t island = 1; island < islands->num_islands; island++) {
+        pid_t pid = fork();
+
+        if (pid < 0) {
+            fprintf(stderr, "Error: Could not fork island %zu\n", island);
+            exit(1);
+        }
+
+        if (pid == 0) {
+            return island;
+        }
+    }
+
+    return 0;
+}
+
+void archipelago_join(const archipelago *islands) {
+    if (getpid() != islands->founder) {
+        return;
+    }
+
+    // The islands are the only children of the first island
+    while (wait(NULL) >= 0 || errno == EINTR) {
+        continue;
+    }
+}
+
+bool archipelago_abandoned(const archipelago *islands) {
+    return getpid() != islands->founder && getppid() != islands->founder;
+}
+
+/**
+ * @brief Orders ranked fitnesses from the fittest to the weakest
+ */
+static int compare_fitness_descending(const void *a, const void *b) {
+    const ranked_fitness *rank_a = a;
+    const ranked_fitness *rank_b = b;
+
+    if (rank_a->fitness != rank_b->fitness) {
+        return rank_a->fitness < rank_b->fitness ? 1 : -1;
+    }
+
+    return rank_a->index < rank_b->index ? -1 : rank_a->index > rank_b->index;
+}
+
+void archipelago_emigrate(archipelago *islands, size_t island, population *pop, evaluator *eval) {
+    // Rank the population without reordering it
+    if (pop->size > islands->population_size) {
+        fprintf(stderr, "Error: The population of %zu individuals does not fit in the migration buffers\n", pop->size);
+        exit(1);
+    }
+
+    ranked_fitness *ranked = islands->ranked;
+
+    for (size_t i = 0; i < pop->size; i++) {
+        ranked[i] = (ranked_fitness){.fitness = pop->fitness[i], .index = i};
+    }
+
+    qsort(ranked, pop->size, sizeof(ranked_fitness), compare_fitness_descending);
+
+    // Verify the best individuals in place, so the population keeps the
+    // verified fitness too, and skip those that break in long double
+    individual *emigrants = islands->migrants;
+    size_t num_emigrants = 0;
+
+    for (size_t i = 0; i < pop->size && num_emigrants < islands->migration_size; i++) {
+        if (ranked[i].fitness == -INFINITY) {
+            break;
+        }
+
+        individual specimen = population_get(pop, ranked[i].index);
+        verify_individual(&specimen, eval);
+        population_set(pop, ranked[i].index, specimen);
+
+        if (specimen.fitness != -INFINITY) {
+            emigrants[num_emigrants++] = specimen;
+        }
+    }
+
+    outbox *box = get_outbox(islands, island);
+    pthread_mutex_lock(&box->lock);
+    memcpy(box->emigrants, emigrants, num_emigrants * sizeof(individual));
+    box->num_emigrants = num_emigrants;
+    box->epoch++;
+    pthread_mutex_unlock(&box->lock);
+}
+
+/**
+ * @brief Replaces the weakest individual of a population with a migrant, if the migrant is fitter
+ *
+ * @return true if the migrant joined the population
+ */
+static bool settle(population *pop, individual migrant) {
+    size_t weakest = 0;
+
+    for (size_t i = 1; i < pop->size; i++) {
+        if (pop->fitness[i] < pop->fitness[weakest]) {
+            weakest = i;
+        }
+    }
+
+    if (pop->size == 0 || migrant.fitness <= pop->fitness[weakest]) {
+        return false;
+    }
+
+    population_set(pop, weakest, migrant);
+    return true;
+}
+
+/**
+ * @brief Collects the migrants of a single sender, if it published new ones
+ */
+static size_t collect(archipelago *islands, size_t receiver, size_t sender, population *pop) {
+    individual *migrants = islands->migrants;
+    size_t num_migrants = 0;
+
+    outbox *box = get_outbox(islands, sender);
+    uint64_t *collected = get_collected(islands, receiver, sender);
+
+    pthread_mutex_lock(&box->lock);
+
+    if (box->epoch != *collected) {
+        num_migrants = box->num_emigrants;
+        memcpy(migrants, box->emigrants, num_migrants * sizeof(individual));
+        *collected = box->epoch;
+    }
+
+    pthread_mutex_unlock(&box->lock);
+
+    size_t num_joined = 0;
+
+    for (size_t i = 0; i < num_migrants; i++) {
+        num_joined += settle(pop, migrants[i]);
+    }
+
+    return num_joined;
+}
+
+size_t archipelago_immigrate(archipelago *islands, size_t island, population *pop) {
+    size_t num_islands = islands->num_islands;
+    size_t num_joined = 0;
+
+    if (islands->topology == TOPOLOGY_RING) {
+        num_joined += collect(islands, island, (island + num_islands - 1) % num_islands, pop);
+    } else {
+        for (size_t sender = 0; sender < num_islands; sender++) {
+            if (sender != island) {
+                num_joined += collect(islands, island, sender, pop);
+            }
+        }
+    }
+
+    return num_joined;
+}
+
+void archipelago_publish_best(archipelago *islands, size_t island, individual best) {
+    outbox *box = get_outbox(islands, island);
+    pthread_mutex_lock(&box->lock);
+    box->best = best;
+    pthread_mutex_unlock(&box->lock);
+}
+
+individual archipelago_get_best(archipelago *islands, size_t island) {
+    outbox *box = get_outbox(islands, island);
+    pthread_mutex_lock(&box->lock);
+    individual best = box->best;
+    pthread_mutex_unlock(&box->lock);
+    return best;
+}
+
+size_t archipelago_size(const archipelago *islands) {
+    return islands->num_islands;
+}
+
+void archipelago_free(archipelago *islands) {
+    free(islands->migrants);
+    free(islands->ranked);
+    munmap(islands, islands->mapping_size);
+}
+
+bool migration_topology_parse(const char *name, migration_topology *topology) {
+    if (strcmp(name, "ring") == 0) {
+        *topology = TOPOLOGY_RING;
+    } else if (strcmp(name, "complete") == 0) {
+        *topology = TOPOLOGY_COMPLETE;
+    } else {
+        return false;
+    }
+
+    return true;
+}
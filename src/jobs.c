@@ -0,0 +1,327 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "jobs.h"
+#include "run.h"
+#include "cache.h"
+#include "utils.h"
+
+/** The most arguments that a line of a job file may hold */
+#define MAX_JOB_ARGUMENTS 64
+
+/**
+ * @brief The state of a job in the schedule
+ */
+typedef enum job_state {
+    JOB_PENDING,
+    JOB_RUNNING,
+    JOB_DONE,
+} job_state;
+
+/**
+ * @struct job
+ * @brief A run listed in a job file.
+ *
+ * @param line The line of the job file that lists the run.
+ * @param text The arguments of the run, which the configuration points into.
+ * @param config The configuration of the run.
+ * @param cores The number of cores that the run keeps busy.
+ * @param state Whether the run is pending, running or done.
+ * @param pid The process of the run, while it is running.
+ * @param result_fd The read end of the pipe the run sends its result through.
+ */
+typedef struct job {
+    size_t line;
+    char *text;
+    run_config config;
+    size_t cores;
+    job_state state;
+    pid_t pid;
+    int result_fd;
+} job;
+
+/**
+ * @brief Splits a line of a job file into arguments, in place
+ *
+ * @return The number of arguments, including a dummy program name
+ */
+static int split_arguments(char *text, char *argv[MAX_JOB_ARGUMENTS]) {
+    int argc = 0;
+    argv[argc++] = "job";
+
+    for (char *token = strtok(text, " \t\r\n"); token != NULL; token = strtok(NULL, " \t\r\n")) {
+        if (argc == MAX_JOB_ARGUMENTS) {
+            return -1;
+        }
+
+        argv[argc++] = token;
+    }
+
+    return argc;
+}
+
+/**
+ * @brief Checks if the arguments of a job set an option
+ */
+static bool has_option(int argc, char *argv[], const char *option) {
+    // The options come in pairs after the 11 positional arguments
+    for (int i = 12; i < argc; i += 2) {
+        if (strcmp(argv[i], option) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Reads and validates the jobs of a job file
+ *
+ * Jobs without --seed would all be seeded from the same clock second, so
+ * each gets its own seed, mixed from a seed shared by the job file and the
+ * line of the job. The program exits if any job is invalid, before any job
+ * is started.
+ */
+static job *read_jobs(const char *path, size_t num_cores, size_t *num_jobs) {
+    FILE *file = fopen(path, "r");
+
+    if (file == NULL) {
+        fprintf(stderr, "Error: Could not open file %s\n", path);
+        exit(1);
+    }
+
+    size_t capacity = 16;
+    job *jobs = malloc(capacity * sizeof(job));
+    check_memory(jobs);
+    *num_jobs = 0;
+
+    char *line = NULL;
+    size_t line_capacity = 0;
+    size_t line_number = 0;
+    uint64_t base_seed = time(NULL);
+
+    while (getline(&line, &line_capacity, file) >= 0) {
+        line_number++;
+
+        // Skip blank lines and comments
+        const char *start = line + strspn(line, " \t\r\n");
+
+        if (*start == '\0' || *start == '#') {
+            continue;
+        }
+
+        if (*num_jobs == capacity) {
+            capacity *= 2;
+            jobs = realloc(jobs, capacity * sizeof(job));
+            check_memory(jobs);
+        }
+
+        job *j = &jobs[(*num_jobs)++];
+        j->line = line_number;
+        j->text = strdup(line);
+        check_memory(j->text);
+        j->state = JOB_PENDING;
+
+        char *argv[MAX_JOB_ARGUMENTS];
+        int argc = split_arguments(j->text, argv);
+
+        if (argc < 0 || !run_config_parse(argc, argv, &j->config)) {
+            fprintf(stderr, "Error: Invalid job on line %zu of %s\n", line_number, path);
+            exit(1);
+        }
+
+        if (!has_option(argc, argv, "--seed")) {
+            j->config.seed = hash_mix(base_seed, line_number);
+        }
+
+        if (j->config.max_generations == 0 && j->config.max_seconds == 0) {
+            fprintf(stderr, "Error: The job on line %zu of %s needs --generations or --time\n", line_number, path);
+            exit(1);
+        }
+
+        j->cores = run_config_cores(&j->config);
+
+        if (j->cores > num_cores) {
+            fprintf(stderr, "Error: The job on line %zu of %s needs %zu cores, but only %zu are available\n", line_number, path, j->cores, num_cores);
+            exit(1);
+        }
+    }
+
+    free(line);
+    fclose(file);
+
+    return jobs;
+}
+
+/**
+ * @brief Starts a job in a new process
+ *
+ * The process writes the progress of the run to a log next to its output,
+ * and sends the result of the run back through a pipe.
+ */
+static void start_job(job *j) {
+    int fds[2];
+
+    if (pipe(fds) != 0) {
+        fprintf(stderr, "Error: Could not create a pipe for the job on line %zu\n", j->line);
+        exit(1);
+    }
+
+    // Buffered output would otherwise be written once by every process
+    fflush(NULL);
+    pid_t pid = fork();
+
+    if (pid < 0) {
+        fprintf(stderr, "Error: Could not fork the job on line %zu\n", j->line);
+        exit(1);
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+
+        size_t length = strlen(j->config.output_path) + 5;
+        char *log_path = malloc(length);
+        check_memory(log_path);
+        snprintf(log_path, length, "%s.log", j->config.output_path);
+
+        if (freopen(log_path, "w", stdout) == NULL) {
+            fprintf(stderr, "Error: Could not open file %s\n", log_path);
+            exit(1);
+        }
+
+        free(log_path);
+
+        // The result fits in the pipe buffer, so this does not block
+        run_result result = run_evolution(&j->config);
+
+        if (write(fds[1], &result, sizeof(result)) != sizeof(result)) {
+            exit(1);
+        }
+
+        exit(0);
+    }
+
+    close(fds[1]);
+    j->pid = pid;
+    j->result_fd = fds[0];
+    j->state = JOB_RUNNING;
+}
+
+/**
+ * @brief Appends the outcome of a finished job to the summary
+ */
+static void write_summary(FILE *summary, const job *j, bool succeeded, const run_result *result) {
+    fprintf(summary, "%zu\t%s\t%" PRIu64 "\t%s", j->line, j->config.output_path, j->config.seed, succeeded ? "ok" : "failed");
+
+    if (succeeded) {
+        fprintf(summary, "\t%zu\t%.3f\t%" FORMAT_SPECIFIER "\t", result->generations, result->seconds, result->best.fitness);
+
+        for (size_t i = 0; i < NUM_LINKS; i++) {
+            fprintf(summary, i == 0 ? "%" FORMAT_SPECIFIER : " %" FORMAT_SPECIFIER, result->best.genes.lengths[i]);
+        }
+
+        fprintf(summary, "\t%zu\t", result->evaluations);
+
+        // Runs that never reached their target leave the column empty
+        if (result->reached_target) {
+            fprintf(summary, "%zu", result->evaluations_to_target);
+        }
+    } else {
+        fprintf(summary, "\t\t\t\t\t\t");
+    }
+
+    fprintf(summary, "\n");
+
+    // Keep the summary complete even if the runner is killed
+    fflush(summary);
+}
+
+int run_jobs(const char *job_path, size_t num_cores, const char *summary_path) {
+    size_t num_jobs;
+    job *jobs = read_jobs(job_path, num_cores, &num_jobs);
+
+    FILE *summary = fopen(summary_path, "w");
+
+    if (summary == NULL) {
+        fprintf(stderr, "Error: Could not open file %s\n", summary_path);
+        exit(1);
+    }
+
+    fprintf(summary, "line\toutput\tseed\tstatus\tgenerations\tseconds\tbest_fitness\tbest_linkage\tevaluations\tevaluations_to_target\n");
+    fflush(summary);
+
+    printf("Running %zu jobs on %zu cores\n", num_jobs, num_cores);
+
+    size_t free_cores = num_cores;
+    size_t num_done = 0;
+    size_t num_failed = 0;
+
+    while (num_done < num_jobs) {
+        // Start every pending job that fits, in order
+        for (size_t i = 0; i < num_jobs; i++) {
+            if (jobs[i].state == JOB_PENDING && jobs[i].cores <= free_cores) {
+                start_job(&jobs[i]);
+                free_cores -= jobs[i].cores;
+                printf("Job on line %zu started on %zu cores with seed %" PRIu64 ", writing to %s\n", jobs[i].line, jobs[i].cores, jobs[i].config.seed, jobs[i].config.output_path);
+            }
+        }
+
+        fflush(stdout);
+
+        // Wait for any job to finish
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+
+        if (pid < 0) {
+            fprintf(stderr, "Error: Lost track of the running jobs\n");
+            exit(1);
+        }
+
+        job *j = NULL;
+
+        for (size_t i = 0; i < num_jobs; i++) {
+            if (jobs[i].state == JOB_RUNNING && jobs[i].pid == pid) {
+                j = &jobs[i];
+            }
+        }
+
+        if (j == NULL) {
+            continue;
+        }
+
+        run_result result;
+        bool succeeded = WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+                         read(j->result_fd, &result, sizeof(result)) == sizeof(result);
+
+        close(j->result_fd);
+        j->state = JOB_DONE;
+        free_cores += j->cores;
+        num_done++;
+
+        write_summary(summary, j, succeeded, &result);
+
+        if (succeeded) {
+            printf("Job on line %zu finished after %zu generations in %.3f seconds: Best fitness = %" FORMAT_SPECIFIER "\n", j->line, result.generations, result.seconds, result.best.fitness);
+        } else {
+            printf("Job on line %zu failed\n", j->line);
+            num_failed++;
+        }
+    }
+
+    printf("Finished %zu jobs, %zu failed, summary written to %s\n", num_jobs, num_failed, summary_path);
+
+    fclose(summary);
+
+    for (size_t i = 0; i < num_jobs; i++) {
+        free(jobs[i].text);
+    }
+
+    free(jobs);
+
+    return num_failed > 0 ? 1 : 0;
+}
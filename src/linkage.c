@@ -1,4 +1,8 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils.h"
 #include "linkage.h"
 
 bool linkage_equals(linkage a, linkage b) {
@@ -17,4 +21,35 @@ void linkage_print(linkage link) {
     }
 
     printf("\n");
-}
\ No newline at end of file
+}
+
+void linkage_write(const char *path, linkage link) {
+    size_t length = strlen(path) + 5;
+    char *temporary_path = malloc(length);
+    check_memory(temporary_path);
+    snprintf(temporary_path, length, "%s.tmp", path);
+
+    FILE *file = fopen(temporary_path, "w");
+
+    if (file == NULL) {
+        fprintf(stderr, "Error: Could not open file %s\n", temporary_path);
+        exit(1);
+    }
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        if (i == NUM_LINKS - 1) {
+            fprintf(file, "%" FORMAT_SPECIFIER, link.lengths[i]);
+        } else {
+            fprintf(file, "%" FORMAT_SPECIFIER " ", link.lengths[i]);
+        }
+    }
+
+    fclose(file);
+
+    if (rename(temporary_path, path) != 0) {
+        fprintf(stderr, "Error: Could not write file %s\n", path);
+        exit(1);
+    }
+
+    free(temporary_path);
+}
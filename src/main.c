@@ -1,16 +1,18 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
+#include <string.h>
+#include <unistd.h>
 
-#include "random.h"
-#include "fkin.h"
-#include "trajectory.h"
-#include "evolution.h"
+#include "run.h"
+#include "jobs.h"
+#include "utils.h"
 
 const char *HELP_MESSAGE = "Usage: ./bin/strandbeest <trajectory_path> <output_path> <log_frequency>        \n"
                            "                         <population_size> <num_survivors> <stride_resolution>  \n"
                            "                         <mutation_rate> <crossover_rate> <noise_scale>         \n"
-                           "                         <noise_absolute> <deterministic_survival>              \n"
+                           "                         <noise_absolute> <deterministic_survival> [options]    \n"
+                           "       ./bin/strandbeest --jobs <job_path> [--cores <num_cores>]                \n"
+                           "                         [--summary <summary_path>]                             \n"
                            "                                                                                \n"
                            "The strandbeest program evolves a population of linkages to match a target foot \n"
                            "path. The target trajectory is specified in a file, where each line contains    \n"
@@ -47,138 +49,166 @@ const char *HELP_MESSAGE = "Usage: ./bin/strandbeest <trajectory_path> <output_p
                            "    noise_absolute: Whether the noise is absolute or relative.                  \n"
                            "    deterministic_survival: Whether the survival is deterministic or stochastic.\n"
                            "                                                                                \n"
+                           "Options:                                                                        \n"
+                           "    --threads <num_threads>: The number of threads used to evaluate the         \n"
+                           "        population (default 1). Results do not depend on the thread count.      \n"
+                           "    --seed <seed>: The seed of the random number generator (default: the current\n"
+                           "        time). Runs with the same seed and arguments are identical.             \n"
+                           "    --fkin <trig|algebraic>: The kernel used to solve the linkage. The algebraic\n"
+                           "        kernel intersects circles without trigonometry (default trig).          \n"
+                           "    --precision <float|double|long>: The precision that offspring are screened  \n"
+                           "        in (default double). Reported linkages are always re-evaluated in long  \n"
+                           "        double.                                                                 \n"
+                           "    --verify-survivors <0|1>: Whether survivors are re-evaluated in long double \n"
+                           "        before they breed, so that no parent breaks at that precision (default  \n"
+                           "        1). Verification can take most of the time at high stride resolutions.  \n"
+                           "    --cache <num_entries>: The number of fitnesses remembered, so that identical\n"
+                           "        offspring are not evaluated twice, or 0 to disable (default 16384).     \n"
+                           "    --coarse <resolution>: Screen the offspring at this stride resolution, which\n"
+                           "        must divide stride_resolution, and only evaluate the promising ones at  \n"
+                           "        full resolution (default 0, which disables screening).                  \n"
+                           "    --coarse-margin <margin>: How far below the weakest survivor the coarse     \n"
+                           "        fitness of a child may be for it to be evaluated at full resolution     \n"
+                           "        (default 0.01).                                                         \n"
+                           "    --phase-invariant <0|1>: Whether the foot path is compared with the target  \n"
+                           "        at the crank phase shift where they match best, found by FFT            \n"
+                           "        cross-correlation, instead of at the crank angles of the waypoints      \n"
+                           "        (default 0). The target is resampled into a smooth closed curve, and    \n"
+                           "        the fitness is the mean distance to it. It needs a stride_resolution    \n"
+                           "        that is a power of 2, and does not support --coarse or polishing.       \n"
+                           "    --replacement <generational|worst|tournament>: How offspring replace the    \n"
+                           "        population (default generational). With worst or tournament, every child\n"
+                           "        is inserted as soon as it is evaluated, in place of the weakest         \n"
+                           "        individual or the weakest of 4 random ones if it is fitter, and         \n"
+                           "        num_survivors only sets the number of children per generation,          \n"
+                           "        population_size - num_survivors. The children of all generations up to  \n"
+                           "        the next report, polishing, migration, checkpoint or dump are bred in   \n"
+                           "        one stream, so threads only wait for each other at those generations,   \n"
+                           "        which are also the only ones logged. Such steady state runs are only    \n"
+                           "        reproducible with a single thread.                                      \n"
+                           "    --polish-interval <generations>: How often the fittest linkages are polished\n"
+                           "        by a projected L-BFGS search within [0, 1], which follows the exact     \n"
+                           "        gradient of the fitness and never breaks them (default 0, which never   \n"
+                           "        polishes).                                                              \n"
+                           "    --polish-count <count>: How many of the fittest linkages are polished       \n"
+                           "        (default 1).                                                            \n"
+                           "    --polish-iterations <iterations>: The most steps of every polishing         \n"
+                           "        (default 20).                                                           \n"
+                           "    --islands <num_islands>: Evolve this many populations in separate processes \n"
+                           "        that exchange their best individuals (default 1). Each island uses      \n"
+                           "        --threads threads. Runs with several islands are not reproducible.      \n"
+                           "    --migration-interval <generations>: How often islands send migrants         \n"
+                           "        (default 10).                                                           \n"
+                           "    --migration-size <num_migrants>: How many individuals every island sends    \n"
+                           "        (default 2).                                                            \n"
+                           "    --topology <ring|complete>: Whether every island receives migrants from the \n"
+                           "        previous island only, or from all of them (default ring).               \n"
+                           "    --checkpoint <path>: Periodically save the state of the run to this file.   \n"
+                           "        With several islands, the index of the island is appended to the path.  \n"
+                           "    --checkpoint-interval <generations>: How often the checkpoint is saved      \n"
+                           "        (default 100).                                                          \n"
+                           "    --resume <path>: Continue the run saved in this checkpoint. The arguments   \n"
+                           "        must match those of the saved run, which then continues identically.    \n"
+                           "    --trace <path>: Write the time spent in every phase of the run to this file \n"
+                           "        as Chrome trace events, for chrome://tracing or Perfetto. With several  \n"
+                           "        islands, the index of the island is appended to the path.               \n"
+                           "    --log <path>: Append a JSON record of every generation to this file. The    \n"
+                           "        file is written by a background thread, which never holds up the run.   \n"
+                           "    --dump-interval <generations>: How often the whole population is also       \n"
+                           "        written to the log (default 0, which never writes it).                  \n"
+                           "    --generations <generation>: Stop at this generation (default 0, which runs  \n"
+                           "        forever). The final linkage and checkpoint are written when stopping.   \n"
+                           "    --time <seconds>: Stop after this many seconds of wall time (default 0,     \n"
+                           "        which runs forever).                                                    \n"
+                           "    --engine <ga|cmaes>: The search strategy (default ga). CMA-ES samples every \n"
+                           "        generation from a normal distribution centered on the best initial      \n"
+                           "        linkage, and adapts it towards the num_survivors fittest samples. It    \n"
+                           "        does not support islands, checkpoints, --replacement or --coarse.       \n"
+                           "    --step-size <step_size>: The initial standard deviation of every link       \n"
+                           "        length sampled by CMA-ES (default 0.1).                                 \n"
+                           "    --target <fitness>: Stop once the best fitness of all time reaches this     \n"
+                           "        value, and report the number of evaluations it took (default: never).   \n"
+                           "                                                                                \n"
+                           "Jobs:                                                                           \n"
+                           "    With --jobs, the program runs every line of the job file as a separate run, \n"
+                           "    written as the arguments above. Lines that start with # are ignored. Every  \n"
+                           "    job needs --generations or --time, and keeps --threads times --islands      \n"
+                           "    cores busy. Jobs start in order as soon as enough cores are free. The       \n"
+                           "    progress of every job is written to its output path with .log appended. Jobs\n"
+                           "    without --seed get distinct seeds, which are listed in the summary.         \n"
+                           "    --cores <num_cores>: The number of cores shared by the jobs (default: all). \n"
+                           "    --summary <summary_path>: The table that the outcome of every job is        \n"
+                           "        appended to (default: the job path with .summary.tsv appended).         \n"
+                           "                                                                                \n"
                            "Example:                                                                        \n"
-                           "    ./bin/strandbeest trajectory.txt linkage.txt 10 1000 250 100 0.5 0 0.01 0 1 \n";
-
-static trajectory *read_target_stride(const char *path) {
-    FILE *file = fopen(path, "r");
-
-    if (file == NULL) {
-        fprintf(stderr, "Error: Could not open file %s\n", path);
-        exit(1);
+                           "    ./bin/strandbeest trajectory.txt linkage.txt 10 1000 250 100 0.5 0 0.01 0 1 \n"
+                           "    ./bin/strandbeest --jobs study.txt --cores 16                               \n";
+
+/**
+ * @brief Parses the arguments of the job mode and runs the jobs
+ */
+static int main_jobs(int argc, char *argv[]) {
+    if (argc % 2 != 1) {
+        fprintf(stderr, "%s", HELP_MESSAGE);
+        return 1;
     }
 
-    // Count the number of lines in the file
-    size_t num_lines = 0;
-    char c;
+    const char *job_path = argv[2];
+    size_t num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *summary_path = NULL;
+
+    for (int i = 3; i < argc; i += 2) {
+        const char *option = argv[i];
+        const char *value = argv[i + 1];
 
-    while ((c = fgetc(file)) != EOF) {
-        if (c == '\n') {
-            num_lines++;
+        if (strcmp(option, "--cores") == 0) {
+            num_cores = strtoull(value, NULL, 10);
+        } else if (strcmp(option, "--summary") == 0) {
+            summary_path = value;
+        } else {
+            fprintf(stderr, "Error: Unknown option %s\n", option);
+            return 1;
         }
     }
 
-    // Allocate memory for the trajectory
-    trajectory *target_stride = trajectory_init(num_lines);
-
-    // Read the waypoints from the file
-    rewind(file);
-
-    for (size_t i = 0; i < num_lines; i++) {
-        waypoint wp;
-        fscanf(file, "%" FORMAT_SPECIFIER " %" FORMAT_SPECIFIER " %" FORMAT_SPECIFIER, &wp.x, &wp.y, &wp.t);
-        target_stride->waypoints[i] = wp;
+    if (num_cores < 1) {
+        fprintf(stderr, "Error: The number of cores must be at least 1\n");
+        return 1;
     }
 
-    fclose(file);
-
-    return target_stride;
-}
-
-static void write_linkage(const char *path, linkage link) {
-    FILE *file = fopen(path, "w");
-
-    if (file == NULL) {
-        fprintf(stderr, "Error: Could not open file %s\n", path);
-        exit(1);
+    if (summary_path != NULL) {
+        return run_jobs(job_path, num_cores, summary_path);
     }
 
-    for (size_t i = 0; i < NUM_LINKS; i++) {
-        if (i == NUM_LINKS - 1) {
-            fprintf(file, "%" FORMAT_SPECIFIER, link.lengths[i]);
-        } else {
-            fprintf(file, "%" FORMAT_SPECIFIER " ", link.lengths[i]);
-        }
-    }
+    size_t length = strlen(job_path) + 13;
+    char *default_summary_path = malloc(length);
+    check_memory(default_summary_path);
+    snprintf(default_summary_path, length, "%s.summary.tsv", job_path);
 
-    fclose(file);
+    int status = run_jobs(job_path, num_cores, default_summary_path);
+    free(default_summary_path);
+
+    return status;
 }
 
 int main(int argc, char* argv[]) {
+    if (argc >= 3 && strcmp(argv[1], "--jobs") == 0) {
+        return main_jobs(argc, argv);
+    }
+
     // Check the command-line arguments
-    if (argc != 12) {
+    if (argc < 12 || argc % 2 != 0) {
         fprintf(stderr, "%s", HELP_MESSAGE);
         return 1;
     }
 
-    srand(time(NULL));
-
-    // Create the target stride
-    const char *trajectory_path = argv[1];
-    const char *output_path = argv[2];
-    const size_t log_frequency = atoi(argv[3]);
-    const size_t population_size = atoi(argv[4]);
-    const size_t num_survivors = atoi(argv[5]);
-    const size_t stride_resolution = atoi(argv[6]);
-    const decimal mutation_rate = atof(argv[7]);
-    const decimal crossover_rate = atof(argv[8]);
-    const decimal noise_scale = atof(argv[9]);
-    const bool noise_absolute = atoi(argv[10]);
-    const bool deterministic_survival = atoi(argv[11]);
-
-    // Read the target stride
-    trajectory *target_stride = read_target_stride(trajectory_path);
-
-    for (size_t i = 0; i < target_stride->length; i++) {
-        printf("Waypoint %zu: (%" FORMAT_SPECIFIER ", %" FORMAT_SPECIFIER ", %" FORMAT_SPECIFIER ")\n", i + 1, target_stride->waypoints[i].x, target_stride->waypoints[i].y, target_stride->waypoints[i].t);
-    }
-    
-    // Initialize the population
-    population *pop = sample_initial_population(population_size, target_stride, stride_resolution);
-    size_t generation = 0;
-    individual best_overall_individual = population_get_best_individual(pop);
-
-    // Generate the strandbeest
-    while (true) {
-        // Report the mean fitness
-        decimal mean_fitness = population_compute_mean_fitness(pop);
-
-        // Report the best individual
-        individual best_individual = population_get_best_individual(pop);
-
-        if (best_individual.fitness > best_overall_individual.fitness) {
-            best_overall_individual = best_individual;
-        }
-
-        // Compute the fraction of the population that breaks
-        decimal breakage_rate = population_get_breakage_rate(pop);
-
-        if (generation % log_frequency == 0) {
-            printf("Generation %zu: Mean fitness of this generation = %" FORMAT_SPECIFIER "\n", generation, mean_fitness);
-            printf("Generation %zu: Best fitness of this generation = %" FORMAT_SPECIFIER ", Best fitness of all time = %" FORMAT_SPECIFIER "\n", generation, best_individual.fitness, best_overall_individual.fitness);
-            printf("Generation %zu: Breakage rate = %" FORMAT_SPECIFIER "\n", generation, breakage_rate);
-            printf("Best linkage of this generation: ");
-            linkage_print(best_individual.genes);
-            printf("Best linkage of all time: ");
-            linkage_print(best_overall_individual.genes);
-            write_linkage(output_path, best_overall_individual.genes);
-        }
+    run_config config;
 
-        // Evolve the population
-        evolve_population(pop, target_stride,
-                          num_survivors,
-                          mutation_rate,
-                          crossover_rate,
-                          noise_scale,
-                          noise_absolute,
-                          deterministic_survival,
-                          stride_resolution);
-
-        generation++;
+    if (!run_config_parse(argc, argv, &config)) {
+        return 1;
     }
 
-    free(pop);
-    free(target_stride);
+    run_evolution(&config);
 
     return 0;
-}
\ No newline at end of file
+}
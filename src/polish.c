@@ -0,0 +1,400 @@
+#include <stdlib.h>
+
+#include "utils.h"
+#include "evolution.h"
+#include "telemetry.h"
+#include "polish.h"
+
+/** The number of past steps that L-BFGS learns the curvature from */
+#define POLISH_MEMORY 5
+
+/** The most times a step is halved before the search gives up */
+#define POLISH_MAX_BACKTRACKS 20
+
+/** The fraction of the predicted improvement that a step must achieve */
+#define POLISH_SUFFICIENT_INCREASE 1e-4
+
+/** The longest change of a link length in a steepest ascent step */
+#define POLISH_MAX_GRADIENT_STEP 0.01
+
+/** The change of a single link length that tells if the linkage is about to break */
+#define POLISH_PROBE_STEP 1e-6
+
+/**
+ * @brief Computes the error of a linkage, which is its negated fitness, and its gradient
+ *
+ * @return The error, or INFINITY if the linkage breaks or its gradient is not finite
+ */
+static decimal evaluate_error(linkage link, evaluator *eval, decimal gradient[NUM_LINKS]) {
+    uint64_t start = telemetry_now(eval->telemetry);
+    decimal fitness = compute_fitness_gradient(link, eval, gradient);
+    telemetry_record_evaluation(eval->telemetry, start);
+    atomic_fetch_add_explicit(&eval->num_evaluations, 1, memory_order_relaxed);
+
+    if (fitness == -INFINITY) {
+        return INFINITY;
+    }
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        if (!isfinite(gradient[i])) {
+            return INFINITY;
+        }
+
+        gradient[i] = -gradient[i];
+    }
+
+    return -fitness;
+}
+
+/**
+ * @brief The past steps of L-BFGS, oldest first
+ */
+typedef struct polish_memory {
+    size_t count;
+    decimal steps[POLISH_MEMORY][NUM_LINKS];
+    decimal changes[POLISH_MEMORY][NUM_LINKS];
+    decimal rho[POLISH_MEMORY];
+} polish_memory;
+
+/**
+ * @brief Remembers a step and the change of the gradient it caused
+ *
+ * Steps along which the error does not curve upwards would make the
+ * direction point uphill, so they are not remembered.
+ */
+static void remember_step(polish_memory *memory, const decimal step[NUM_LINKS], const decimal change[NUM_LINKS]) {
+    decimal curvature = 0;
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        curvature += step[i] * change[i];
+    }
+
+    if (!(curvature > 0)) {
+        return;
+    }
+
+    if (memory->count == POLISH_MEMORY) {
+        // Forget the oldest step
+        for (size_t k = 1; k < POLISH_MEMORY; k++) {
+            for (size_t i = 0; i < NUM_LINKS; i++) {
+                memory->steps[k - 1][i] = memory->steps[k][i];
+                memory->changes[k - 1][i] = memory->changes[k][i];
+            }
+
+            memory->rho[k - 1] = memory->rho[k];
+        }
+
+        memory->count--;
+    }
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        memory->steps[memory->count][i] = step[i];
+        memory->changes[memory->count][i] = change[i];
+    }
+
+    memory->rho[memory->count] = 1 / curvature;
+    memory->count++;
+}
+
+/**
+ * @brief Holds the links whose change alone breaks the linkage
+ *
+ * Polished linkages often end up against the boundary beyond which they
+ * break, where every step along the gradient breaks them. Every free link
+ * is moved a tiny step downhill on its own, and the links that break the
+ * linkage are held from then on, so that the search can slide along the
+ * boundary.
+ *
+ * @return The number of links that are newly held
+ */
+static size_t hold_breaking_links(linkage current, const decimal gradient[NUM_LINKS], const bool free[NUM_LINKS], bool held[NUM_LINKS], evaluator *eval) {
+    size_t num_held = 0;
+    decimal probe_gradient[NUM_LINKS];
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        if (!free[i] || gradient[i] == 0) {
+            continue;
+        }
+
+        linkage probe = current;
+        decimal length = probe.lengths[i] + (gradient[i] > 0 ? -POLISH_PROBE_STEP : POLISH_PROBE_STEP);
+        probe.lengths[i] = length < 0 ? 0 : length > 1 ? 1 : length;
+
+        if (evaluate_error(probe, eval, probe_gradient) == INFINITY) {
+            held[i] = true;
+            num_held++;
+        }
+    }
+
+    return num_held;
+}
+
+/**
+ * @brief Computes the L-BFGS direction over the free links
+ *
+ * This is the two-loop recursion, with the links held at their bounds left
+ * out of every product, so that they keep a direction of 0.
+ */
+static void compute_direction(const polish_memory *memory, const decimal gradient[NUM_LINKS], const bool free[NUM_LINKS], decimal direction[NUM_LINKS]) {
+    decimal alpha[POLISH_MEMORY];
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        direction[i] = free[i] ? gradient[i] : 0;
+    }
+
+    for (size_t k = memory->count; k-- > 0;) {
+        decimal dot = 0;
+
+        for (size_t i = 0; i < NUM_LINKS; i++) {
+            dot += free[i] ? memory->steps[k][i] * direction[i] : 0;
+        }
+
+        alpha[k] = memory->rho[k] * dot;
+
+        for (size_t i = 0; i < NUM_LINKS; i++) {
+            direction[i] -= free[i] ? alpha[k] * memory->changes[k][i] : 0;
+        }
+    }
+
+    // Scale by the curvature of the latest step
+    if (memory->count > 0) {
+        const decimal *change = memory->changes[memory->count - 1];
+        decimal squared_norm = 0;
+
+        for (size_t i = 0; i < NUM_LINKS; i++) {
+            squared_norm += change[i] * change[i];
+        }
+
+        decimal scale = 1 / (memory->rho[memory->count - 1] * squared_norm);
+
+        for (size_t i = 0; i < NUM_LINKS; i++) {
+            direction[i] *= scale;
+        }
+    }
+
+    for (size_t k = 0; k < memory->count; k++) {
+        decimal dot = 0;
+
+        for (size_t i = 0; i < NUM_LINKS; i++) {
+            dot += free[i] ? memory->changes[k][i] * direction[i] : 0;
+        }
+
+        decimal beta = memory->rho[k] * dot;
+
+        for (size_t i = 0; i < NUM_LINKS; i++) {
+            direction[i] += free[i] ? (alpha[k] - beta) * memory->steps[k][i] : 0;
+        }
+    }
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        direction[i] = free[i] ? -direction[i] : 0;
+    }
+}
+
+bool polish_individual(individual *specimen, evaluator *eval, size_t max_iterations) {
+    linkage current = specimen->genes;
+    decimal gradient[NUM_LINKS];
+    decimal error = evaluate_error(current, eval, gradient);
+
+    if (error == INFINITY) {
+        return false;
+    }
+
+    decimal initial_error = error;
+    polish_memory memory = {.count = 0};
+    bool held[NUM_LINKS];
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        held[i] = false;
+    }
+
+    for (size_t iteration = 0; iteration < max_iterations; iteration++) {
+        // Hold the links that are at a bound and would leave [0, 1], and
+        // those that break the linkage
+        bool free[NUM_LINKS];
+
+        for (size_t i = 0; i < NUM_LINKS; i++) {
+            decimal length = current.lengths[i];
+            free[i] = !held[i] && !((length <= 0 && gradient[i] > 0) || (length >= 1 && gradient[i] < 0));
+        }
+
+        decimal direction[NUM_LINKS];
+        compute_direction(&memory, gradient, free, direction);
+
+        decimal slope = 0;
+
+        for (size_t i = 0; i < NUM_LINKS; i++) {
+            slope += gradient[i] * direction[i];
+        }
+
+        // Fall back to the steepest descent of the error if the curvature
+        // learnt so far does not lead downhill
+        if (!(slope < 0)) {
+            memory.count = 0;
+            compute_direction(&memory, gradient, free, direction);
+            slope = 0;
+
+            for (size_t i = 0; i < NUM_LINKS; i++) {
+                slope += gradient[i] * direction[i];
+            }
+
+            if (!(slope < 0)) {
+                break;
+            }
+        }
+
+        // Without curvature, the length of the gradient says nothing about
+        // how far to go, so the first step is kept short
+        decimal step_size = 1;
+
+        if (memory.count == 0) {
+            decimal longest = 0;
+
+            for (size_t i = 0; i < NUM_LINKS; i++) {
+                longest = abs(direction[i]) > longest ? abs(direction[i]) : longest;
+            }
+
+            if (longest > POLISH_MAX_GRADIENT_STEP) {
+                step_size = POLISH_MAX_GRADIENT_STEP / longest;
+            }
+        }
+
+        bool accepted = false;
+        linkage candidate;
+        decimal candidate_gradient[NUM_LINKS];
+        decimal candidate_error = INFINITY;
+
+        for (size_t backtrack = 0; backtrack < POLISH_MAX_BACKTRACKS && !accepted; backtrack++) {
+            // Project the step onto [0, 1]
+            decimal predicted = 0;
+
+            for (size_t i = 0; i < NUM_LINKS; i++) {
+                decimal length = current.lengths[i] + step_size * direction[i];
+                candidate.lengths[i] = length < 0 ? 0 : length > 1 ? 1 : length;
+                predicted += gradient[i] * (candidate.lengths[i] - current.lengths[i]);
+            }
+
+            candidate_error = evaluate_error(candidate, eval, candidate_gradient);
+            accepted = candidate_error < error && candidate_error <= error + POLISH_SUFFICIENT_INCREASE * predicted;
+            step_size /= 2;
+        }
+
+        if (!accepted) {
+            // Start over without the links that break the linkage, unless
+            // the search is stuck for another reason
+            if (candidate_error == INFINITY && hold_breaking_links(current, gradient, free, held, eval) > 0) {
+                memory.count = 0;
+                continue;
+            }
+
+            break;
+        }
+
+        decimal step[NUM_LINKS];
+        decimal change[NUM_LINKS];
+
+        for (size_t i = 0; i < NUM_LINKS; i++) {
+            step[i] = candidate.lengths[i] - current.lengths[i];
+            change[i] = candidate_gradient[i] - gradient[i];
+            gradient[i] = candidate_gradient[i];
+        }
+
+        remember_step(&memory, step, change);
+        current = candidate;
+        error = candidate_error;
+    }
+
+    if (!(error < initial_error)) {
+        return false;
+    }
+
+    specimen->genes = current;
+    specimen->fitness = -error;
+    specimen->verified = true;
+
+    return true;
+}
+
+/**
+ * @brief The shared state of a parallel polishing
+ */
+typedef struct polishing_job {
+    population *pop;
+    evaluator *eval;
+    const size_t *indices;
+    size_t max_iterations;
+    bool *improved;
+} polishing_job;
+
+/**
+ * @brief Polishes a single individual of a polishing job
+ */
+static void polish_job_individual(void *context, size_t index) {
+    polishing_job *job = context;
+    size_t position = job->indices[index];
+    individual specimen = population_get(job->pop, position);
+    job->improved[index] = polish_individual(&specimen, job->eval, job->max_iterations);
+    population_set(job->pop, position, specimen);
+}
+
+size_t polish_population(population *pop, size_t count, size_t max_iterations, evaluator *eval, thread_pool *pool) {
+    count = count < pop->size ? count : pop->size;
+
+    size_t *indices = malloc((count > 0 ? count : 1) * sizeof(size_t));
+    check_memory(indices);
+    bool *improved = malloc((count > 0 ? count : 1) * sizeof(bool));
+    check_memory(improved);
+
+    // Pick the fittest unbroken individuals, the fittest first, and the
+    // lower index first among equals. Only a few are polished, so a scan
+    // per individual is cheap.
+    size_t num_picked = 0;
+
+    while (num_picked < count) {
+        size_t best_index = pop->size;
+
+        for (size_t i = 0; i < pop->size; i++) {
+            decimal fitness = pop->fitness[i];
+
+            // Skip the individuals that were picked already
+            if (num_picked > 0) {
+                size_t last = indices[num_picked - 1];
+
+                if (fitness > pop->fitness[last] || (fitness == pop->fitness[last] && i <= last)) {
+                    continue;
+                }
+            }
+
+            if (fitness != -INFINITY && (best_index == pop->size || fitness > pop->fitness[best_index])) {
+                best_index = i;
+            }
+        }
+
+        if (best_index == pop->size) {
+            break;
+        }
+
+        indices[num_picked++] = best_index;
+    }
+
+    polishing_job job = {
+        .pop = pop,
+        .eval = eval,
+        .indices = indices,
+        .max_iterations = max_iterations,
+        .improved = improved,
+    };
+
+    pool_parallel_for(pool, num_picked, polish_job_individual, &job);
+
+    size_t num_improved = 0;
+
+    for (size_t i = 0; i < num_picked; i++) {
+        num_improved += improved[i];
+    }
+
+    free(indices);
+    free(improved);
+
+    return num_improved;
+}
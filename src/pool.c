@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "utils.h"
+#include "pool.h"
+
+struct thread_pool {
+    size_t num_workers;
+    pthread_t *workers;
+
+    pthread_mutex_t lock;
+    pthread_cond_t job_ready;
+    pthread_cond_t job_done;
+
+    // The current job, guarded by the lock
+    pool_task task;
+    void *context;
+    size_t n;
+    size_t job_id;
+    size_t num_busy;
+    bool shutdown;
+
+    // The next index to hand out
+    atomic_size_t next;
+
+    // The number of workers that have started, which numbers them
+    atomic_size_t num_started;
+};
+
+/** The index of the calling thread in its pool, which is 0 outside of the workers */
+static _Thread_local size_t thread_index = 0;
+
+/**
+ * @brief Processes indices of the current job until there are none left.
+ */
+static void drain(thread_pool *pool, pool_task task, void *context, size_t n) {
+    size_t index;
+
+    while ((index = atomic_fetch_add_explicit(&pool->next, 1, memory_order_relaxed)) < n) {
+        task(context, index);
+    }
+}
+
+static void *worker_main(void *arg) {
+    thread_pool *pool = arg;
+    size_t seen_job_id = 0;
+    thread_index = 1 + atomic_fetch_add_explicit(&pool->num_started, 1, memory_order_relaxed);
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (true) {
+        while (!pool->shutdown && pool->job_id == seen_job_id) {
+            pthread_cond_wait(&pool->job_ready, &pool->lock);
+        }
+
+        if (pool->shutdown) {
+            break;
+        }
+
+        seen_job_id = pool->job_id;
+
+        pool_task task = pool->task;
+        void *context = pool->context;
+        size_t n = pool->n;
+
+        pthread_mutex_unlock(&pool->lock);
+        drain(pool, task, context, n);
+        pthread_mutex_lock(&pool->lock);
+
+        if (--pool->num_busy == 0) {
+            pthread_cond_signal(&pool->job_done);
+        }
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+thread_pool *pool_init(size_t num_threads) {
+    thread_pool *pool = malloc(sizeof(thread_pool));
+    check_memory(pool);
+
+    pool->num_workers = num_threads > 1 ? num_threads - 1 : 0;
+    pool->workers = calloc(pool->num_workers + 1, sizeof(pthread_t));
+    check_memory(pool->workers);
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->job_ready, NULL);
+    pthread_cond_init(&pool->job_done, NULL);
+
+    pool->task = NULL;
+    pool->context = NULL;
+    pool->n = 0;
+    pool->job_id = 0;
+    pool->num_busy = 0;
+    pool->shutdown = false;
+    atomic_init(&pool->next, 0);
+    atomic_init(&pool->num_started, 0);
+
+    for (size_t i = 0; i < pool->num_workers; i++) {
+        if (pthread_create(&pool->workers[i], NULL, worker_main, pool) != 0) {
+            fprintf(stderr, "Error: Could not create worker thread\n");
+            exit(1);
+        }
+    }
+
+    return pool;
+}
+
+size_t pool_size(thread_pool *pool) {
+    return pool == NULL ? 1 : pool->num_workers + 1;
+}
+
+size_t pool_thread_index(void) {
+    return thread_index;
+}
+
+void pool_parallel_for(thread_pool *pool, size_t n, pool_task task, void *context) {
+    if (pool == NULL || pool->num_workers == 0 || n <= 1) {
+        for (size_t i = 0; i < n; i++) {
+            task(context, i);
+        }
+
+        return;
+    }
+
+    // Publish the job and wake up the workers
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->context = context;
+    pool->n = n;
+    pool->num_busy = pool->num_workers;
+    atomic_store_explicit(&pool->next, 0, memory_order_relaxed);
+    pool->job_id++;
+    pthread_cond_broadcast(&pool->job_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    // Help out, then wait for the workers to finish their last items
+    drain(pool, task, context, n);
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (pool->num_busy > 0) {
+        pthread_cond_wait(&pool->job_done, &pool->lock);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void pool_free(thread_pool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->job_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->num_workers; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->job_ready);
+    pthread_cond_destroy(&pool->job_done);
+
+    free(pool->workers);
+    free(pool);
+}
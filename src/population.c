@@ -1,21 +1,72 @@
 #include <stdlib.h>
+#include <string.h>
 
 #include "utils.h"
 #include "population.h"
 
 population *population_init(size_t size) {
-    population *pop = malloc(sizeof(population) + size * sizeof(individual));
+    population *pop = malloc(sizeof(population));
     check_memory(pop);
     pop->size = size;
+    pop->capacity = size;
+
+    // Keep the arrays valid for an empty population
+    pop->genes = malloc((size > 0 ? size : 1) * sizeof(linkage));
+    check_memory(pop->genes);
+    pop->fitness = malloc((size > 0 ? size : 1) * sizeof(decimal));
+    check_memory(pop->fitness);
+    pop->verified = malloc((size > 0 ? size : 1) * sizeof(bool));
+    check_memory(pop->verified);
+
     return pop;
 }
 
-decimal population_compute_mean_fitness(population *pop) {
+void population_free(population *pop) {
+    free(pop->genes);
+    free(pop->fitness);
+    free(pop->verified);
+    free(pop);
+}
+
+individual population_get(const population *pop, size_t index) {
+    return (individual){
+        .genes = pop->genes[index],
+        .fitness = pop->fitness[index],
+        .verified = pop->verified[index],
+    };
+}
+
+void population_set(population *pop, size_t index, individual specimen) {
+    pop->genes[index] = specimen.genes;
+    pop->fitness[index] = specimen.fitness;
+    pop->verified[index] = specimen.verified;
+}
+
+void population_copy_individual(population *dst, size_t dst_index, const population *src, size_t src_index) {
+    dst->genes[dst_index] = src->genes[src_index];
+    dst->fitness[dst_index] = src->fitness[src_index];
+    dst->verified[dst_index] = src->verified[src_index];
+}
+
+void population_copy(population *dst, const population *src) {
+    memcpy(dst->genes, src->genes, src->size * sizeof(linkage));
+    memcpy(dst->fitness, src->fitness, src->size * sizeof(decimal));
+    memcpy(dst->verified, src->verified, src->size * sizeof(bool));
+    dst->size = src->size;
+}
+
+void population_swap(population *a, population *b) {
+    population temporary = *a;
+    *a = *b;
+    *b = temporary;
+}
+
+decimal population_compute_mean_fitness(const population *pop) {
     decimal total_fitness = 0;
     size_t n = 0;
 
     for (size_t i = 0; i < pop->size; i++) {
-        decimal fitness = pop->individuals[i].fitness;
+        decimal fitness = pop->fitness[i];
 
         if (fitness != -INFINITY) {
             total_fitness += fitness;
@@ -26,45 +77,55 @@ decimal population_compute_mean_fitness(population *pop) {
     return total_fitness / n;
 }
 
-decimal *population_compute_survival_chances(population *pop) {
-    decimal totalExpFitness = 0;
+void population_compute_survival_chances(const population *pop, decimal *survival_chances) {
+    decimal max_fitness = -INFINITY;
 
     for (size_t i = 0; i < pop->size; i++) {
-        totalExpFitness += exp(pop->individuals[i].fitness);
+        if (pop->fitness[i] > max_fitness) {
+            max_fitness = pop->fitness[i];
+        }
+    }
+
+    if (max_fitness == -INFINITY) {
+        for (size_t i = 0; i < pop->size; i++) {
+            survival_chances[i] = 0;
+        }
+
+        return;
     }
 
-    decimal *survival_chances = malloc(pop->size * sizeof(decimal));
-    check_memory(survival_chances);
+    decimal totalExpFitness = 0;
 
     for (size_t i = 0; i < pop->size; i++) {
-        survival_chances[i] = exp(pop->individuals[i].fitness) / totalExpFitness;
+        survival_chances[i] = exp(pop->fitness[i] - max_fitness);
+        totalExpFitness += survival_chances[i];
     }
 
-    return survival_chances;
+    for (size_t i = 0; i < pop->size; i++) {
+        survival_chances[i] /= totalExpFitness;
+    }
 }
 
-individual population_get_best_individual(population *pop) {
-    individual best_individual = pop->individuals[0];
+individual population_get_best_individual(const population *pop) {
+    size_t best_index = 0;
 
     for (size_t i = 1; i < pop->size; i++) {
-        individual specimen = pop->individuals[i];
-
-        if (specimen.fitness > best_individual.fitness) {
-            best_individual = specimen;
+        if (pop->fitness[i] > pop->fitness[best_index]) {
+            best_index = i;
         }
     }
 
-    return best_individual;
+    return population_get(pop, best_index);
 }
 
-decimal population_get_breakage_rate(population *pop) {
+decimal population_get_breakage_rate(const population *pop) {
     size_t num_broken = 0;
 
     for (size_t i = 0; i < pop->size; i++) {
-        if (pop->individuals[i].fitness == -INFINITY) {
+        if (pop->fitness[i] == -INFINITY) {
             num_broken++;
         }
     }
 
     return (decimal)num_broken / pop->size;
-}
\ No newline at end of file
+}
@@ -0,0 +1,119 @@
+#include "prepared.h"
+
+/**
+ * @brief Appends the interval where the crank distance AB exceeds a bound
+ *
+ * The interval is centered on phi, where AB is longest.
+ */
+static size_t add_upper_bound(crank_interval intervals[], size_t count, decimal phi, decimal mean, decimal amplitude, decimal bound) {
+    // AB^2 = mean + amplitude * cos(theta - phi) > bound^2
+    decimal half_width;
+
+    if (amplitude == 0) {
+        half_width = mean > bound * bound ? M_PI : 0;
+    } else {
+        decimal threshold = (bound * bound - mean) / amplitude;
+        half_width = threshold >= 1 ? 0 : threshold < -1 ? M_PI : acos(threshold);
+    }
+
+    if (half_width > 0) {
+        intervals[count++] = (crank_interval){.center = phi, .half_width = half_width};
+    }
+
+    return count;
+}
+
+/**
+ * @brief Appends the interval where the crank distance AB falls short of a bound
+ *
+ * The interval is centered on phi + pi, where AB is shortest.
+ */
+static size_t add_lower_bound(crank_interval intervals[], size_t count, decimal phi, decimal mean, decimal amplitude, decimal bound) {
+    // AB^2 = mean + amplitude * cos(theta - phi) < bound^2
+    decimal half_width;
+
+    if (amplitude == 0) {
+        half_width = mean < bound * bound ? M_PI : 0;
+    } else {
+        decimal threshold = (bound * bound - mean) / amplitude;
+        half_width = threshold <= -1 ? 0 : threshold > 1 ? M_PI : M_PI - acos(threshold);
+    }
+
+    if (half_width > 0) {
+        intervals[count++] = (crank_interval){.center = phi + M_PI, .half_width = half_width};
+    }
+
+    return count;
+}
+
+size_t linkage_crank_breakage(linkage link, crank_interval intervals[NUM_CRANK_BOUNDS]) {
+    decimal a = link.lengths[0];
+    decimal b = link.lengths[1];
+    decimal c = link.lengths[2];
+    decimal j = link.lengths[9];
+    decimal k = link.lengths[10];
+    decimal l = link.lengths[11];
+    decimal m = link.lengths[12];
+
+    // AB^2 oscillates around its mean as the crank turns
+    decimal phi = atan2(l, a);
+    decimal mean = m * m + a * a + l * l;
+    decimal amplitude = 2 * m * sqrt(a * a + l * l);
+
+    size_t count = 0;
+    count = add_upper_bound(intervals, count, phi, mean, amplitude, b + j);
+    count = add_lower_bound(intervals, count, phi, mean, amplitude, abs(b - j));
+    count = add_upper_bound(intervals, count, phi, mean, amplitude, c + k);
+    count = add_lower_bound(intervals, count, phi, mean, amplitude, abs(c - k));
+
+    return count;
+}
+
+bool linkage_prepare(linkage link, prepared_linkage *prepared) {
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        prepared->lengths[i] = link.lengths[i];
+        prepared->squared[i] = prepared->lengths[i] * prepared->lengths[i];
+    }
+
+    decimal b = link.lengths[1];
+    decimal d = link.lengths[3];
+    decimal e = link.lengths[4];
+    decimal g = link.lengths[6];
+    decimal h = link.lengths[7];
+    decimal i = link.lengths[8];
+
+    // The rigid triangles must not be degenerate
+    if (b + d <= e || g + h <= i) {
+        return false;
+    }
+
+    decimal cosGamma = (b * b + d * d - e * e) / (2 * b * d);
+
+    if (abs(cosGamma) > 1) {
+        return false;
+    }
+
+    decimal cosEta = (g * g + i * i - h * h) / (2 * g * i);
+
+    if (abs(cosEta) > 1) {
+        return false;
+    }
+
+    // The dyads attached to the crank must close over the whole revolution
+    crank_interval intervals[NUM_CRANK_BOUNDS];
+
+    if (linkage_crank_breakage(link, intervals) > 0) {
+        return false;
+    }
+
+    prepared->gamma = acos(cosGamma);
+    prepared->eta = acos(cosEta);
+
+    // Both angles are in [0, pi], so their sines are non-negative
+    prepared->cos_gamma = cosGamma;
+    prepared->sin_gamma = sqrt(1 - cosGamma * cosGamma);
+    prepared->cos_eta = cosEta;
+    prepared->sin_eta = sqrt(1 - cosEta * cosEta);
+
+    return true;
+}
@@ -1,37 +1,95 @@
-#include <stdlib.h>
-
 #include "random.h"
 
-decimal rnd() {
-    return (decimal)rand() / RAND_MAX;
+/**
+ * @brief Advances a splitmix64 state and returns the next output
+ *
+ * This is only used to expand seeds into full generator states.
+ */
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
 }
 
-decimal uniform(decimal lo, decimal hi) {
-    return rnd() * (hi - lo) + lo;
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
 }
 
-decimal normal(decimal mean, decimal stddev) {
-    decimal u1 = rnd();
-    decimal u2 = rnd();
-    decimal r = sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
-    return mean + stddev * r;
+void rng_seed(rng *r, uint64_t seed, uint64_t stream) {
+    uint64_t state = seed ^ splitmix64(&stream);
+
+    for (size_t i = 0; i < 4; i++) {
+        r->s[i] = splitmix64(&state);
+    }
 }
 
-size_t sample(decimal *probs, size_t n) {
-    decimal r = rnd();
-    decimal cumulativeProb = 0;
+uint64_t rng_next(rng *r) {
+    uint64_t *s = r->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
 
-    for (size_t i = 0; i < n; i++) {
-        if (probs[i] <= 0) {
-            continue;
-        }
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+size_t rng_below(rng *r, size_t n) {
+    // Lemire's multiply-and-reject method
+    uint64_t x = rng_next(r);
+    __uint128_t m = (__uint128_t)x * n;
+    uint64_t low = (uint64_t)m;
 
-        cumulativeProb += probs[i];
+    if (low < n) {
+        uint64_t threshold = -(uint64_t)n % n;
 
-        if (r < cumulativeProb) {
-            return i;
+        while (low < threshold) {
+            x = rng_next(r);
+            m = (__uint128_t)x * n;
+            low = (uint64_t)m;
         }
     }
 
-    return n - 1;
-}
\ No newline at end of file
+    return m >> 64;
+}
+
+decimal rnd(rng *r) {
+#if USE_FLOAT
+    return (decimal)(rng_next(r) >> 40) * 0x1.0p-24f;
+#else
+    return (decimal)(rng_next(r) >> 11) * 0x1.0p-53;
+#endif
+}
+
+decimal normal(rng *r, decimal mean, decimal stddev) {
+    decimal u1 = 1 - rnd(r);
+    decimal u2 = rnd(r);
+    decimal z = sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+    return mean + stddev * z;
+}
+
+void rnd_fill(rng *r, decimal *values, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        values[i] = rnd(r);
+    }
+}
+
+void normal_fill(rng *r, decimal *values, size_t n, decimal mean, decimal stddev) {
+    for (size_t i = 0; i < n; i += 2) {
+        decimal u1 = 1 - rnd(r);
+        decimal u2 = rnd(r);
+        decimal radius = sqrt(-2 * log(u1));
+        decimal angle = 2 * M_PI * u2;
+
+        values[i] = mean + stddev * radius * cos(angle);
+
+        if (i + 1 < n) {
+            values[i + 1] = mean + stddev * radius * sin(angle);
+        }
+    }
+}
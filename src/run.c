@@ -0,0 +1,731 @@
+#include <stdio.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "run.h"
+#include "random.h"
+#include "fkin.h"
+#include "trajectory.h"
+#include "evaluator.h"
+#include "evolution.h"
+#include "utils.h"
+#include "pool.h"
+#include "run_log.h"
+#include "cmaes.h"
+#include "polish.h"
+#include "fft.h"
+#include "cache.h"
+
+/** The number of generation records that may wait for the log writer */
+#define RUN_LOG_CAPACITY 1024
+
+/**
+ * @brief Gets the path of a file of an island
+ *
+ * In runs with several islands, every island has its own file, whose path
+ * ends with the index of the island.
+ *
+ * @return The path, which the caller must free, or NULL if the path is NULL
+ */
+static char *get_island_path(const char *path, size_t island, bool suffixed) {
+    if (path == NULL) {
+        return NULL;
+    }
+
+    size_t length = strlen(path) + 32;
+    char *island_path = malloc(length);
+    check_memory(island_path);
+
+    if (suffixed) {
+        snprintf(island_path, length, "%s.%zu", path, island);
+    } else {
+        snprintf(island_path, length, "%s", path);
+    }
+
+    return island_path;
+}
+
+/**
+ * @brief Gets the wall time elapsed since a start time, in seconds
+ */
+static double get_elapsed_seconds(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Gets the number of generations to the next multiple of an interval
+ */
+static size_t get_generations_to_multiple(size_t generation, size_t interval) {
+    return interval - generation % interval;
+}
+
+/**
+ * @brief Gets the number of generations until the run has to do more than evolve
+ *
+ * The steady state breeds the children of all of these generations in a
+ * single stream, so that the threads only wait for each other at reports,
+ * polishing, migration, checkpoints, dumps and the end of the run.
+ */
+static size_t get_steady_state_span(const run_config *config, size_t generation, bool migrating, bool checkpointing) {
+    const run_parameters *parameters = &config->parameters;
+    size_t span = get_generations_to_multiple(generation, config->log_frequency);
+    size_t intervals[] = {
+        parameters->polish_interval,
+        migrating ? config->migration_interval : 0,
+        checkpointing ? config->checkpoint_interval : 0,
+        config->dump_interval,
+    };
+
+    for (size_t i = 0; i < sizeof(intervals) / sizeof(intervals[0]); i++) {
+        if (intervals[i] > 0 && get_generations_to_multiple(generation, intervals[i]) < span) {
+            span = get_generations_to_multiple(generation, intervals[i]);
+        }
+    }
+
+    if (config->max_generations > 0 && config->max_generations - generation < span) {
+        span = config->max_generations - generation;
+    }
+
+    return span;
+}
+
+bool run_config_parse(int argc, char *argv[], run_config *config) {
+    if (argc < 12 || argc % 2 != 0) {
+        fprintf(stderr, "Error: Expected 11 arguments followed by options in pairs\n");
+        return false;
+    }
+
+    config->trajectory_path = argv[1];
+    config->output_path = argv[2];
+    config->log_frequency = atoi(argv[3]);
+    config->parameters = (run_parameters){
+        .population_size = atoi(argv[4]),
+        .num_survivors = atoi(argv[5]),
+        .stride_resolution = atoi(argv[6]),
+        .mutation_rate = atof(argv[7]),
+        .crossover_rate = atof(argv[8]),
+        .noise_scale = atof(argv[9]),
+        .noise_absolute = atoi(argv[10]),
+        .deterministic_survival = atoi(argv[11]),
+        .backend = FKIN_DEFAULT_BACKEND,
+        .screening = PRECISION_DOUBLE,
+        .coarse_resolution = 0,
+        .coarse_margin = 0.01,
+        .replacement = REPLACEMENT_GENERATIONAL,
+        .polish_interval = 0,
+        .polish_count = 1,
+        .polish_iterations = 20,
+        .phase_invariant = false,
+        .verify_survivors = true,
+    };
+
+    // Parse the options
+    config->seed = time(NULL);
+    config->num_threads = 1;
+    config->cache_capacity = 16384;
+    config->num_islands = 1;
+    config->migration_interval = 10;
+    config->migration_size = 2;
+    config->topology = TOPOLOGY_RING;
+    config->checkpoint_path = NULL;
+    config->checkpoint_interval = 100;
+    config->resume_path = NULL;
+    config->trace_path = NULL;
+    config->log_path = NULL;
+    config->dump_interval = 0;
+    config->max_generations = 0;
+    config->max_seconds = 0;
+    config->engine = ENGINE_GA;
+    config->step_size = 0.1;
+    config->target_fitness = INFINITY;
+
+    run_parameters *parameters = &config->parameters;
+
+    for (int i = 12; i < argc; i += 2) {
+        const char *option = argv[i];
+        const char *value = argv[i + 1];
+
+        if (strcmp(option, "--threads") == 0) {
+            config->num_threads = atoi(value);
+        } else if (strcmp(option, "--seed") == 0) {
+            config->seed = strtoull(value, NULL, 10);
+        } else if (strcmp(option, "--fkin") == 0) {
+            if (!fkin_backend_parse(value, &parameters->backend)) {
+                fprintf(stderr, "Error: Unknown fkin backend %s\n", value);
+                return false;
+            }
+        } else if (strcmp(option, "--precision") == 0) {
+            if (!precision_parse(value, &parameters->screening)) {
+                fprintf(stderr, "Error: Unknown precision %s\n", value);
+                return false;
+            }
+        } else if (strcmp(option, "--cache") == 0) {
+            config->cache_capacity = strtoull(value, NULL, 10);
+        } else if (strcmp(option, "--coarse") == 0) {
+            parameters->coarse_resolution = strtoull(value, NULL, 10);
+        } else if (strcmp(option, "--coarse-margin") == 0) {
+            parameters->coarse_margin = atof(value);
+        } else if (strcmp(option, "--islands") == 0) {
+            config->num_islands = strtoull(value, NULL, 10);
+        } else if (strcmp(option, "--migration-interval") == 0) {
+            config->migration_interval = strtoull(value, NULL, 10);
+        } else if (strcmp(option, "--migration-size") == 0) {
+            config->migration_size = strtoull(value, NULL, 10);
+        } else if (strcmp(option, "--checkpoint") == 0) {
+            config->checkpoint_path = value;
+        } else if (strcmp(option, "--checkpoint-interval") == 0) {
+            config->checkpoint_interval = strtoull(value, NULL, 10);
+        } else if (strcmp(option, "--resume") == 0) {
+            config->resume_path = value;
+        } else if (strcmp(option, "--trace") == 0) {
+            config->trace_path = value;
+        } else if (strcmp(option, "--log") == 0) {
+            config->log_path = value;
+        } else if (strcmp(option, "--dump-interval") == 0) {
+            config->dump_interval = strtoull(value, NULL, 10);
+        } else if (strcmp(option, "--generations") == 0) {
+            config->max_generations = strtoull(value, NULL, 10);
+        } else if (strcmp(option, "--time") == 0) {
+            config->max_seconds = atof(value);
+        } else if (strcmp(option, "--replacement") == 0) {
+            if (!replacement_policy_parse(value, &parameters->replacement)) {
+                fprintf(stderr, "Error: Unknown replacement policy %s\n", value);
+                return false;
+            }
+        } else if (strcmp(option, "--polish-interval") == 0) {
+            parameters->polish_interval = strtoull(value, NULL, 10);
+        } else if (strcmp(option, "--polish-count") == 0) {
+            parameters->polish_count = strtoull(value, NULL, 10);
+        } else if (strcmp(option, "--polish-iterations") == 0) {
+            parameters->polish_iterations = strtoull(value, NULL, 10);
+        } else if (strcmp(option, "--phase-invariant") == 0) {
+            parameters->phase_invariant = atoi(value);
+        } else if (strcmp(option, "--verify-survivors") == 0) {
+            parameters->verify_survivors = atoi(value);
+        } else if (strcmp(option, "--engine") == 0) {
+            if (strcmp(value, "ga") == 0) {
+                config->engine = ENGINE_GA;
+            } else if (strcmp(value, "cmaes") == 0) {
+                config->engine = ENGINE_CMAES;
+            } else {
+                fprintf(stderr, "Error: Unknown engine %s\n", value);
+                return false;
+            }
+        } else if (strcmp(option, "--step-size") == 0) {
+            config->step_size = atof(value);
+        } else if (strcmp(option, "--target") == 0) {
+            config->target_fitness = atof(value);
+        } else if (strcmp(option, "--topology") == 0) {
+            if (!migration_topology_parse(value, &config->topology)) {
+                fprintf(stderr, "Error: Unknown topology %s\n", value);
+                return false;
+            }
+        } else {
+            fprintf(stderr, "Error: Unknown option %s\n", option);
+            return false;
+        }
+    }
+
+    if (config->log_frequency < 1) {
+        fprintf(stderr, "Error: The log frequency must be at least 1\n");
+        return false;
+    }
+
+    if (parameters->population_size < 1) {
+        fprintf(stderr, "Error: The population size must be at least 1\n");
+        return false;
+    }
+
+    if (parameters->num_survivors < 1 || parameters->num_survivors > parameters->population_size) {
+        fprintf(stderr, "Error: The number of survivors must be between 1 and the population size\n");
+        return false;
+    }
+
+    if (config->num_threads < 1) {
+        fprintf(stderr, "Error: The number of threads must be at least 1\n");
+        return false;
+    }
+
+    size_t coarse_resolution = parameters->coarse_resolution;
+    size_t stride_resolution = parameters->stride_resolution;
+
+    if (coarse_resolution > 0 && (coarse_resolution >= stride_resolution || stride_resolution % coarse_resolution != 0)) {
+        fprintf(stderr, "Error: The coarse resolution must be a proper divisor of the stride resolution\n");
+        return false;
+    }
+
+    if (parameters->phase_invariant) {
+        if (!fft_supports(stride_resolution)) {
+            fprintf(stderr, "Error: The phase invariant fitness needs a stride resolution that is a power of 2\n");
+            return false;
+        }
+
+        if (coarse_resolution > 0 || parameters->polish_interval > 0) {
+            fprintf(stderr, "Error: Coarse screening and polishing are not supported with the phase invariant fitness\n");
+            return false;
+        }
+    }
+
+    if (config->num_islands < 1 || config->migration_interval < 1 || config->migration_size < 1) {
+        fprintf(stderr, "Error: The number of islands, the migration interval and the migration size must be at least 1\n");
+        return false;
+    }
+
+    if (config->migration_size > parameters->population_size) {
+        fprintf(stderr, "Error: The migration size must not exceed the population size\n");
+        return false;
+    }
+
+    if (config->checkpoint_interval < 1) {
+        fprintf(stderr, "Error: The checkpoint interval must be at least 1\n");
+        return false;
+    }
+
+    if (config->max_seconds < 0) {
+        fprintf(stderr, "Error: The time budget must not be negative\n");
+        return false;
+    }
+
+    if (config->engine == ENGINE_CMAES) {
+        if (config->num_islands > 1 || config->checkpoint_path != NULL || config->resume_path != NULL) {
+            fprintf(stderr, "Error: Islands and checkpoints are not supported by the CMA-ES engine\n");
+            return false;
+        }
+
+        if (parameters->replacement != REPLACEMENT_GENERATIONAL || coarse_resolution > 0) {
+            fprintf(stderr, "Error: Steady state replacement and coarse screening are not supported by the CMA-ES engine\n");
+            return false;
+        }
+
+        if (!(config->step_size > 0)) {
+            fprintf(stderr, "Error: The step size must be positive\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t run_config_cores(const run_config *config) {
+    return config->num_threads * config->num_islands;
+}
+
+run_result run_evolution(const run_config *config) {
+    const run_parameters *parameters = &config->parameters;
+    uint64_t seed = config->seed;
+
+    struct timespec run_start;
+    clock_gettime(CLOCK_MONOTONIC, &run_start);
+
+    // Split into islands before any threads are started. Only the first
+    // island reports the progress of the run, and writes the output.
+    archipelago *islands = NULL;
+    size_t island = 0;
+
+    if (config->num_islands > 1) {
+        islands = archipelago_init(config->num_islands, config->migration_size, parameters->population_size, config->topology);
+        island = archipelago_fork(islands);
+    }
+
+    thread_pool *pool = pool_init(config->num_threads);
+
+    // Every island draws from its own stream
+    rng generator;
+    rng_seed(&generator, seed, island);
+
+    // Every island saves and resumes its own checkpoint
+    char *checkpoint_file = get_island_path(config->checkpoint_path, island, islands != NULL);
+    char *resume_file = get_island_path(config->resume_path, island, islands != NULL);
+    char *trace_file = get_island_path(config->trace_path, island, islands != NULL);
+    char *log_file = get_island_path(config->log_path, island, islands != NULL);
+    const checkpoint *resumed = NULL;
+
+    if (resume_file != NULL) {
+        resumed = checkpoint_map(resume_file);
+
+        if (!run_parameters_equals(&resumed->parameters, parameters)) {
+            fprintf(stderr, "Error: The checkpoint %s was saved with different arguments\n", resume_file);
+            exit(1);
+        }
+
+        seed = resumed->seed;
+    }
+
+    // Read the target stride
+    trajectory *target_stride = trajectory_read(config->trajectory_path);
+
+    if (island == 0) {
+        printf("Seed: %" PRIu64 "\n", seed);
+
+        for (size_t i = 0; i < target_stride->length; i++) {
+            printf("Waypoint %zu: (%" FORMAT_SPECIFIER ", %" FORMAT_SPECIFIER ", %" FORMAT_SPECIFIER ")\n", i + 1, target_stride->waypoints[i].x, target_stride->waypoints[i].y, target_stride->waypoints[i].t);
+        }
+    }
+    
+    // Initialize the population
+    evaluator *eval = evaluator_init(target_stride,
+                                     parameters->stride_resolution,
+                                     parameters->backend,
+                                     parameters->screening,
+                                     config->cache_capacity,
+                                     parameters->coarse_resolution,
+                                     parameters->coarse_margin,
+                                     parameters->phase_invariant,
+                                     config->num_threads);
+    telemetry *t = telemetry_init(trace_file, island);
+    eval->telemetry = t;
+
+    // The log and the output file are written in the background
+    run_log *log = run_log_init(log_file, island == 0 ? config->output_path : NULL, RUN_LOG_CAPACITY);
+
+    population *pop;
+    size_t generation;
+    size_t num_children = 0;
+    individual best_overall_individual;
+
+    // The children of the steady state draw from streams of their own, which
+    // are numbered across the run rather than drawn from the generator
+    uint64_t children_seed = hash_mix(seed, island);
+
+    if (resumed != NULL) {
+        // Pick up the run where the checkpoint left it
+        pop = checkpoint_get_population(resumed);
+        generation = resumed->generation;
+        num_children = resumed->num_children;
+        generator = resumed->generator;
+        best_overall_individual = resumed->best_overall;
+        checkpoint_unmap(resumed);
+
+        if (island == 0) {
+            printf("Resumed from generation %zu of %s\n", generation, resume_file);
+        }
+    } else {
+        pop = sample_initial_population(parameters->population_size, eval, &generator, pool);
+        generation = 0;
+        best_overall_individual = get_verified_best_individual(pop, eval);
+    }
+
+    // Every generation is bred in the same buffers, so the loop below does
+    // not allocate memory
+    generation_buffers *buffers = generation_buffers_init(pop->size);
+
+    // CMA-ES starts from the best linkage of the initial population, and
+    // moves towards as many of its samples as the genetic algorithm keeps
+    cmaes *es = NULL;
+
+    if (config->engine == ENGINE_CMAES) {
+        es = cmaes_init(best_overall_individual.genes, config->step_size, pop->size, parameters->num_survivors);
+    }
+
+    bool reached_target = false;
+    size_t evaluations_to_target = 0;
+
+    size_t reported_lookups = 0;
+    size_t reported_hits = 0;
+    size_t num_immigrants = 0;
+    size_t num_inserted = 0;
+    size_t num_polished = 0;
+    double seconds_per_generation = 0;
+    bool abandoned = false;
+    bool steady_state = es == NULL && parameters->replacement != REPLACEMENT_GENERATIONAL;
+
+    // Generate the strandbeest
+    while (true) {
+        // Report the mean fitness
+        decimal mean_fitness = population_compute_mean_fitness(pop);
+
+        // Report the best individual. The steady state is only looked at,
+        // so that how often the run reports does not change it
+        individual best_individual = steady_state ? peek_verified_best_individual(pop, eval, buffers) : get_verified_best_individual(pop, eval);
+
+        if (best_individual.fitness > best_overall_individual.fitness) {
+            best_overall_individual = best_individual;
+        }
+
+        if (!reached_target && best_overall_individual.fitness >= config->target_fitness) {
+            reached_target = true;
+            evaluations_to_target = atomic_load(&eval->num_evaluations);
+        }
+
+        if (islands != NULL) {
+            // The islands stop once the first one is gone
+            if (archipelago_abandoned(islands)) {
+                abandoned = true;
+                break;
+            }
+
+            archipelago_publish_best(islands, island, best_overall_individual);
+        }
+
+        // Compute the fraction of the population that breaks
+        decimal breakage_rate = population_get_breakage_rate(pop);
+
+        if (island == 0 && generation % config->log_frequency == 0) {
+            uint64_t start = telemetry_now(t);
+
+            if (islands != NULL) {
+                // The best of all time is the best of the whole archipelago
+                printf("Generation %zu: Best fitness of each island =", generation);
+
+                for (size_t i = 0; i < config->num_islands; i++) {
+                    individual island_best = archipelago_get_best(islands, i);
+                    printf(" %" FORMAT_SPECIFIER, island_best.fitness);
+
+                    if (island_best.fitness > best_overall_individual.fitness) {
+                        best_overall_individual = island_best;
+                    }
+                }
+
+                printf("\n");
+                printf("Generation %zu: Received %zu migrants since the last report\n", generation, num_immigrants);
+                num_immigrants = 0;
+            }
+
+            printf("Generation %zu: Mean fitness of this generation = %" FORMAT_SPECIFIER "\n", generation, mean_fitness);
+            printf("Generation %zu: Best fitness of this generation = %" FORMAT_SPECIFIER ", Best fitness of all time = %" FORMAT_SPECIFIER "\n", generation, best_individual.fitness, best_overall_individual.fitness);
+            printf("Generation %zu: Breakage rate = %" FORMAT_SPECIFIER "\n", generation, breakage_rate);
+
+            if (parameters->screening != PRECISION_LONG_DOUBLE) {
+                // Verified individuals screened unbroken, while the sampled
+                // offspring screened broken, so the two count opposite errors
+                size_t num_verified = atomic_load(&eval->num_verified);
+                size_t num_disagreements = atomic_load(&eval->num_disagreements);
+                size_t num_broken_sampled = atomic_load(&eval->num_broken_sampled);
+                size_t num_broken_disagreements = atomic_load(&eval->num_broken_disagreements);
+                double disagreement_rate = num_verified > 0 ? (double)num_disagreements / num_verified : 0;
+                double broken_disagreement_rate = num_broken_sampled > 0 ? (double)num_broken_disagreements / num_broken_sampled : 0;
+                printf("Generation %zu: Breakage disagreements = %zu of %zu verified (%.4f%%), %zu of %zu sampled broken offspring (%.4f%%)\n",
+                       generation, num_disagreements, num_verified, 100 * disagreement_rate, num_broken_disagreements, num_broken_sampled, 100 * broken_disagreement_rate);
+            }
+
+            if (eval->cache != NULL) {
+                // Only count the lookups since the last report, so that the
+                // random initial population does not dilute the hit rate
+                size_t num_lookups = fitness_cache_lookups(eval->cache) - reported_lookups;
+                size_t num_hits = fitness_cache_hits(eval->cache) - reported_hits;
+                double hit_rate = num_lookups > 0 ? (double)num_hits / num_lookups : 0;
+                printf("Generation %zu: Fitness cache hit rate = %zu of %zu evaluations (%.4f%%)\n", generation, num_hits, num_lookups, 100 * hit_rate);
+                reported_lookups += num_lookups;
+                reported_hits += num_hits;
+            }
+
+            if (eval->coarse_angles != NULL) {
+                // Compare the crank configurations solved with those that
+                // evaluating every child at full resolution would have taken
+                size_t num_screened = atomic_load(&eval->num_screened);
+                size_t num_refined = atomic_load(&eval->num_refined);
+                size_t num_rank_changes = atomic_load(&eval->num_rank_changes);
+                double coarse_work = parameters->coarse_resolution + target_stride->length;
+                double full_work = parameters->stride_resolution + target_stride->length;
+                double work = num_screened * coarse_work + num_refined * full_work;
+                double saving = num_screened > 0 ? 1 - work / (num_screened * full_work) : 0;
+                printf("Generation %zu: Coarse screening refined %zu of %zu offspring, saving %.2f%% of the work, %zu rankings changed\n", generation, num_refined, num_screened, 100 * saving, num_rank_changes);
+            }
+
+            if (parameters->replacement != REPLACEMENT_GENERATIONAL) {
+                printf("Generation %zu: Steady state inserted %zu offspring since the last report\n", generation, num_inserted);
+                num_inserted = 0;
+            }
+
+            if (parameters->polish_interval > 0) {
+                printf("Generation %zu: Polishing improved %zu linkages since the last report\n", generation, num_polished);
+                num_polished = 0;
+            }
+
+            if (es != NULL) {
+                printf("Generation %zu: CMA-ES step size = %" FORMAT_SPECIFIER "\n", generation, cmaes_get_step_size(es));
+            }
+
+            printf("Best linkage of this generation: ");
+            linkage_print(best_individual.genes);
+            printf("Best linkage of all time: ");
+            linkage_print(best_overall_individual.genes);
+            telemetry_report(t, generation);
+            telemetry_record_phase(t, PHASE_LOGGING, start);
+        }
+
+        if (island != 0 && generation % config->log_frequency == 0) {
+            uint64_t start = telemetry_now(t);
+            telemetry_flush(t, generation);
+            telemetry_record_phase(t, PHASE_LOGGING, start);
+        }
+
+        generation_record record = {
+            .generation = generation,
+            .seconds = get_elapsed_seconds(&run_start),
+            .mean_fitness = mean_fitness,
+            .breakage_rate = breakage_rate,
+            .best = best_individual,
+            .best_overall = best_overall_individual,
+        };
+
+        bool dump = config->dump_interval > 0 && generation % config->dump_interval == 0;
+        run_log_push(log, &record, dump ? pop : NULL);
+
+        // Stop once the budget is exhausted or the target is reached
+        if (reached_target) {
+            break;
+        }
+
+        if (config->max_generations > 0 && generation >= config->max_generations) {
+            break;
+        }
+
+        if (config->max_seconds > 0 && get_elapsed_seconds(&run_start) >= config->max_seconds) {
+            break;
+        }
+
+        // Evolve the population
+        size_t num_generations = 1;
+
+        if (es != NULL) {
+            cmaes_generation(es, pop, eval, &generator, pool);
+        } else if (parameters->replacement == REPLACEMENT_GENERATIONAL) {
+            evolve_population(pop, eval,
+                              parameters->num_survivors,
+                              parameters->mutation_rate,
+                              parameters->crossover_rate,
+                              parameters->noise_scale,
+                              parameters->noise_absolute,
+                              parameters->deterministic_survival,
+                              parameters->verify_survivors,
+                              &generator,
+                              pool,
+                              buffers);
+        } else {
+            // A generation of the steady state breeds as many children as
+            // a generational one, and the generations up to the next thing
+            // the run has to do are bred in a single stream
+            size_t num_offspring = parameters->num_survivors < pop->size ? pop->size - parameters->num_survivors : 0;
+            num_generations = get_steady_state_span(config, generation, islands != NULL, checkpoint_file != NULL);
+
+            // Do not overrun the time budget by more than a generation, going
+            // by how long the previous generations took
+            double stream_start = get_elapsed_seconds(&run_start);
+
+            if (config->max_seconds > 0) {
+                double affordable = seconds_per_generation > 0 ? (config->max_seconds - stream_start) / seconds_per_generation : 1;
+
+                if (affordable < num_generations) {
+                    num_generations = affordable >= 1 ? (size_t)affordable : 1;
+                }
+            }
+
+            num_inserted += evolve_population_steady_state(pop, eval,
+                                                           num_generations * num_offspring,
+                                                           parameters->mutation_rate,
+                                                           parameters->crossover_rate,
+                                                           parameters->noise_scale,
+                                                           parameters->noise_absolute,
+                                                           parameters->replacement,
+                                                           parameters->verify_survivors,
+                                                           children_seed,
+                                                           num_children,
+                                                           pool,
+                                                           buffers);
+            num_children += num_generations * num_offspring;
+            seconds_per_generation = (get_elapsed_seconds(&run_start) - stream_start) / num_generations;
+        }
+
+        generation += num_generations;
+
+        // Follow the gradient from the fittest linkages
+        if (parameters->polish_interval > 0 && generation % parameters->polish_interval == 0) {
+            uint64_t start = telemetry_now(t);
+            num_polished += polish_population(pop, parameters->polish_count, parameters->polish_iterations, eval, pool);
+            telemetry_record_phase(t, PHASE_POLISHING, start);
+        }
+
+        // Exchange migrants with the other islands
+        if (islands != NULL && generation % config->migration_interval == 0) {
+            uint64_t start = telemetry_now(t);
+            archipelago_emigrate(islands, island, pop, eval);
+            num_immigrants += archipelago_immigrate(islands, island, pop);
+            telemetry_record_phase(t, PHASE_MIGRATION, start);
+        }
+
+        // Save the state of the run between two generations
+        if (checkpoint_file != NULL && generation % config->checkpoint_interval == 0) {
+            uint64_t start = telemetry_now(t);
+            checkpoint_write(checkpoint_file, parameters, seed, generation, num_children, &generator, best_overall_individual, pop);
+            telemetry_record_phase(t, PHASE_CHECKPOINT, start);
+        }
+    }
+
+    // Save the final state, so that the run can be extended later
+    if (checkpoint_file != NULL && !abandoned && generation % config->checkpoint_interval != 0) {
+        checkpoint_write(checkpoint_file, parameters, seed, generation, num_children, &generator, best_overall_individual, pop);
+    }
+
+    telemetry_free(t);
+    eval->telemetry = NULL;
+
+    size_t num_dropped = run_log_dropped(log);
+    run_log_free(log);
+
+    if (num_dropped > 0) {
+        fprintf(stderr, "Warning: %zu records were dropped from the log of island %zu, which could not keep up\n", num_dropped, island);
+    }
+
+    run_result result = {
+        .generations = generation,
+        .best = best_overall_individual,
+        .evaluations = atomic_load(&eval->num_evaluations),
+        .reached_target = reached_target,
+        .evaluations_to_target = evaluations_to_target,
+    };
+
+    if (islands != NULL) {
+        if (island != 0) {
+            // Only the first island returns to the caller
+            exit(0);
+        }
+
+        // The best of all time is the best of the whole archipelago
+        archipelago_join(islands);
+
+        for (size_t i = 0; i < config->num_islands; i++) {
+            individual island_best = archipelago_get_best(islands, i);
+
+            if (island_best.fitness > result.best.fitness) {
+                result.best = island_best;
+            }
+        }
+
+        archipelago_free(islands);
+    }
+
+    result.seconds = get_elapsed_seconds(&run_start);
+
+    printf("Finished after %zu generations in %.3f seconds: Best fitness of all time = %" FORMAT_SPECIFIER "\n", result.generations, result.seconds, result.best.fitness);
+    printf("Best linkage of all time: ");
+    linkage_print(result.best.genes);
+    linkage_write(config->output_path, result.best.genes);
+
+    if (result.reached_target) {
+        printf("Evaluations: %zu in total, %zu to reach the target fitness\n", result.evaluations, result.evaluations_to_target);
+    } else {
+        printf("Evaluations: %zu in total\n", result.evaluations);
+    }
+
+    free(checkpoint_file);
+    free(resume_file);
+    free(trace_file);
+    free(log_file);
+    pool_free(pool);
+    population_free(pop);
+    generation_buffers_free(buffers);
+
+    if (es != NULL) {
+        cmaes_free(es);
+    }
+
+    evaluator_free(eval);
+    free(target_stride);
+
+    return result;
+}
@@ -0,0 +1,251 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "utils.h"
+#include "linkage.h"
+#include "run_log.h"
+
+/**
+ * @brief A record waiting to be written
+ *
+ * @param record The record of the generation
+ * @param pop A copy of the population to dump, or NULL
+ */
+typedef struct log_entry {
+    generation_record record;
+    population *pop;
+} log_entry;
+
+struct run_log {
+    FILE *file;
+    const char *output_path;
+    pthread_t writer;
+
+    pthread_mutex_t lock;
+    pthread_cond_t entry_ready;
+
+    // The queue, a ring buffer guarded by the lock
+    log_entry *entries;
+    size_t capacity;
+    size_t head;
+    size_t count;
+    size_t num_dropped;
+    bool shutdown;
+
+    // The linkage last written to the output file, only used by the writer
+    bool has_output;
+    linkage output;
+};
+
+/**
+ * @brief Writes a number as JSON, which has no infinities
+ */
+static void write_number(FILE *file, decimal value) {
+    if (isfinite(value)) {
+        fprintf(file, "%.17g", (double)value);
+    } else {
+        fprintf(file, "null");
+    }
+}
+
+/**
+ * @brief Writes the lengths of a linkage as a JSON array
+ */
+static void write_genes(FILE *file, linkage link) {
+    fprintf(file, "[");
+
+    for (size_t i = 0; i < NUM_LINKS; i++) {
+        if (i > 0) {
+            fprintf(file, ", ");
+        }
+
+        write_number(file, link.lengths[i]);
+    }
+
+    fprintf(file, "]");
+}
+
+/**
+ * @brief Writes the record of a generation, and the population if any
+ */
+static void write_entry(FILE *file, const log_entry *entry) {
+    const generation_record *record = &entry->record;
+
+    fprintf(file, "{\"type\": \"generation\", \"generation\": %zu, \"seconds\": %.6f, \"mean_fitness\": ", record->generation, record->seconds);
+    write_number(file, record->mean_fitness);
+    fprintf(file, ", \"breakage_rate\": ");
+    write_number(file, record->breakage_rate);
+    fprintf(file, ", \"best_fitness\": ");
+    write_number(file, record->best.fitness);
+    fprintf(file, ", \"best_genes\": ");
+    write_genes(file, record->best.genes);
+    fprintf(file, ", \"best_overall_fitness\": ");
+    write_number(file, record->best_overall.fitness);
+    fprintf(file, ", \"best_overall_genes\": ");
+    write_genes(file, record->best_overall.genes);
+    fprintf(file, "}\n");
+
+    if (entry->pop == NULL) {
+        return;
+    }
+
+    fprintf(file, "{\"type\": \"population\", \"generation\": %zu, \"individuals\": [", record->generation);
+
+    for (size_t i = 0; i < entry->pop->size; i++) {
+        fprintf(file, i > 0 ? ", {\"fitness\": " : "{\"fitness\": ");
+        write_number(file, entry->pop->fitness[i]);
+        fprintf(file, ", \"genes\": ");
+        write_genes(file, entry->pop->genes[i]);
+        fprintf(file, "}");
+    }
+
+    fprintf(file, "]}\n");
+}
+
+static void *writer_main(void *arg) {
+    run_log *log = arg;
+
+    pthread_mutex_lock(&log->lock);
+
+    while (true) {
+        while (!log->shutdown && log->count == 0) {
+            pthread_cond_wait(&log->entry_ready, &log->lock);
+        }
+
+        if (log->count == 0) {
+            break;
+        }
+
+        log_entry entry = log->entries[log->head];
+        log->head = (log->head + 1) % log->capacity;
+        log->count--;
+        bool drained = log->count == 0;
+
+        // Write without holding the lock, so that pushing never waits
+        pthread_mutex_unlock(&log->lock);
+
+        if (log->file != NULL) {
+            write_entry(log->file, &entry);
+
+            // Hand the records to the operating system once caught up
+            if (drained) {
+                fflush(log->file);
+            }
+        }
+
+        linkage best = entry.record.best_overall.genes;
+
+        if (log->output_path != NULL && (!log->has_output || !linkage_equals(log->output, best))) {
+            linkage_write(log->output_path, best);
+            log->has_output = true;
+            log->output = best;
+        }
+
+        if (entry.pop != NULL) {
+            population_free(entry.pop);
+        }
+
+        pthread_mutex_lock(&log->lock);
+    }
+
+    pthread_mutex_unlock(&log->lock);
+
+    return NULL;
+}
+
+run_log *run_log_init(const char *log_path, const char *output_path, size_t capacity) {
+    run_log *log = malloc(sizeof(run_log));
+    check_memory(log);
+
+    log->file = NULL;
+
+    if (log_path != NULL) {
+        log->file = fopen(log_path, "a");
+
+        if (log->file == NULL) {
+            fprintf(stderr, "Error: Could not open file %s\n", log_path);
+            exit(1);
+        }
+    }
+
+    log->output_path = output_path;
+    log->entries = malloc(capacity * sizeof(log_entry));
+    check_memory(log->entries);
+    log->capacity = capacity;
+    log->head = 0;
+    log->count = 0;
+    log->num_dropped = 0;
+    log->shutdown = false;
+    log->has_output = false;
+
+    pthread_mutex_init(&log->lock, NULL);
+    pthread_cond_init(&log->entry_ready, NULL);
+
+    if (pthread_create(&log->writer, NULL, writer_main, log) != 0) {
+        fprintf(stderr, "Error: Could not start the log writer\n");
+        exit(1);
+    }
+
+    return log;
+}
+
+bool run_log_push(run_log *log, const generation_record *record, const population *pop) {
+    pthread_mutex_lock(&log->lock);
+
+    if (log->count == log->capacity) {
+        log->num_dropped++;
+        pthread_mutex_unlock(&log->lock);
+        return false;
+    }
+
+    pthread_mutex_unlock(&log->lock);
+
+    // Copy the population outside of the lock. Only this thread pushes, so
+    // the free slot cannot be taken in the meantime.
+    population *copy = NULL;
+
+    if (pop != NULL && log->file != NULL) {
+        copy = population_init(pop->size);
+        population_copy(copy, pop);
+    }
+
+    pthread_mutex_lock(&log->lock);
+
+    log->entries[(log->head + log->count) % log->capacity] = (log_entry){
+        .record = *record,
+        .pop = copy,
+    };
+    log->count++;
+
+    pthread_cond_signal(&log->entry_ready);
+    pthread_mutex_unlock(&log->lock);
+
+    return true;
+}
+
+size_t run_log_dropped(run_log *log) {
+    pthread_mutex_lock(&log->lock);
+    size_t num_dropped = log->num_dropped;
+    pthread_mutex_unlock(&log->lock);
+
+    return num_dropped;
+}
+
+void run_log_free(run_log *log) {
+    pthread_mutex_lock(&log->lock);
+    log->shutdown = true;
+    pthread_cond_signal(&log->entry_ready);
+    pthread_mutex_unlock(&log->lock);
+
+    pthread_join(log->writer, NULL);
+
+    if (log->file != NULL) {
+        fclose(log->file);
+    }
+
+    pthread_mutex_destroy(&log->lock);
+    pthread_cond_destroy(&log->entry_ready);
+    free(log->entries);
+    free(log);
+}
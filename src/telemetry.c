@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils.h"
+#include "telemetry.h"
+
+/** The names of the phases, in the order of telemetry_phase */
+static const char *PHASE_NAMES[NUM_PHASES] = {
+    "sampling",
+    "selection",
+    "verification",
+    "breeding",
+    "polishing",
+    "migration",
+    "checkpoint",
+    "logging",
+};
+
+telemetry *telemetry_init(const char *trace_path, size_t trace_pid) {
+    telemetry *t = calloc(1, sizeof(telemetry));
+    check_memory(t);
+
+    clock_gettime(CLOCK_MONOTONIC, &t->origin);
+    t->trace_pid = trace_pid;
+
+    if (trace_path != NULL) {
+        t->trace = fopen(trace_path, "w");
+
+        if (t->trace == NULL) {
+            fprintf(stderr, "Error: Could not open file %s\n", trace_path);
+            exit(1);
+        }
+
+        fprintf(t->trace, "[\n");
+    }
+
+    return t;
+}
+
+uint64_t telemetry_now(const telemetry *t) {
+    if (t == NULL) {
+        return 0;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)(now.tv_sec - t->origin.tv_sec) * 1000000000 + (now.tv_nsec - t->origin.tv_nsec);
+}
+
+/**
+ * @brief Starts a new event of the trace
+ *
+ * Every event but the first is separated from the previous one by a comma.
+ */
+static void begin_trace_event(telemetry *t) {
+    if (t->num_trace_events++ > 0) {
+        fprintf(t->trace, ",\n");
+    }
+}
+
+void telemetry_record_phase(telemetry *t, telemetry_phase phase, uint64_t start) {
+    if (t == NULL) {
+        return;
+    }
+
+    uint64_t end = telemetry_now(t);
+    t->phase_ns[phase] += end - start;
+
+    if (t->trace != NULL) {
+        // Trace timestamps are in microseconds
+        begin_trace_event(t);
+        fprintf(t->trace,
+                "{\"name\": \"%s\", \"cat\": \"phase\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": %zu, \"tid\": 0}",
+                PHASE_NAMES[phase], start / 1e3, (end - start) / 1e3, t->trace_pid);
+    }
+}
+
+void telemetry_record_evaluation(telemetry *t, uint64_t start) {
+    if (t == NULL) {
+        return;
+    }
+
+    atomic_fetch_add_explicit(&t->evaluation_ns, telemetry_now(t) - start, memory_order_relaxed);
+}
+
+void telemetry_count_rejected(telemetry *t) {
+    if (t == NULL) {
+        return;
+    }
+
+    atomic_fetch_add_explicit(&t->num_rejected, 1, memory_order_relaxed);
+}
+
+void telemetry_count_sweep(telemetry *t, size_t num_fkin, bool broken, size_t step, size_t resolution) {
+    if (t == NULL) {
+        return;
+    }
+
+    atomic_fetch_add_explicit(&t->num_sweeps, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&t->num_fkin, num_fkin, memory_order_relaxed);
+
+    if (broken) {
+        atomic_fetch_add_explicit(&t->num_broken, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&t->breakage_bins[step * NUM_BREAKAGE_BINS / resolution], 1, memory_order_relaxed);
+    }
+}
+
+telemetry_totals telemetry_get_totals(const telemetry *t) {
+    telemetry_totals totals;
+
+    totals.seconds = telemetry_now(t) / 1e9;
+    memcpy(totals.phase_ns, t->phase_ns, sizeof(totals.phase_ns));
+    totals.evaluation_ns = atomic_load_explicit(&t->evaluation_ns, memory_order_relaxed);
+    totals.num_rejected = atomic_load_explicit(&t->num_rejected, memory_order_relaxed);
+    totals.num_sweeps = atomic_load_explicit(&t->num_sweeps, memory_order_relaxed);
+    totals.num_fkin = atomic_load_explicit(&t->num_fkin, memory_order_relaxed);
+    totals.num_broken = atomic_load_explicit(&t->num_broken, memory_order_relaxed);
+
+    for (size_t i = 0; i < NUM_BREAKAGE_BINS; i++) {
+        totals.breakage_bins[i] = atomic_load_explicit(&t->breakage_bins[i], memory_order_relaxed);
+    }
+
+    return totals;
+}
+
+/**
+ * @brief Writes the rates since the last report to the trace as counters, and flushes the trace
+ */
+static void write_counters(telemetry *t, const telemetry_totals *now, size_t generation) {
+    if (t->trace == NULL) {
+        return;
+    }
+
+    const telemetry_totals *last = &t->reported;
+    double seconds = now->seconds - last->seconds;
+    uint64_t num_evaluations = now->num_rejected - last->num_rejected + now->num_sweeps - last->num_sweeps;
+    uint64_t num_fkin = now->num_fkin - last->num_fkin;
+    double evaluations_per_second = seconds > 0 ? num_evaluations / seconds : 0;
+    double fkin_per_second = seconds > 0 ? num_fkin / seconds : 0;
+
+    uint64_t ts = telemetry_now(t);
+    begin_trace_event(t);
+    fprintf(t->trace,
+            "{\"name\": \"throughput\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": %zu, \"args\": {\"evaluations_per_second\": %.0f, \"fkin_per_second\": %.0f}}",
+            ts / 1e3, t->trace_pid, evaluations_per_second, fkin_per_second);
+    begin_trace_event(t);
+    fprintf(t->trace,
+            "{\"name\": \"generation\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": %zu, \"args\": {\"generation\": %zu}}",
+            ts / 1e3, t->trace_pid, generation);
+    fflush(t->trace);
+}
+
+void telemetry_report(telemetry *t, size_t generation) {
+    telemetry_totals now = telemetry_get_totals(t);
+    const telemetry_totals *last = &t->reported;
+
+    double seconds = now.seconds - last->seconds;
+    uint64_t num_rejected = now.num_rejected - last->num_rejected;
+    uint64_t num_sweeps = now.num_sweeps - last->num_sweeps;
+    uint64_t num_evaluations = num_rejected + num_sweeps;
+    uint64_t num_fkin = now.num_fkin - last->num_fkin;
+    uint64_t num_broken = now.num_broken - last->num_broken;
+    double evaluations_per_second = seconds > 0 ? num_evaluations / seconds : 0;
+    double fkin_per_second = seconds > 0 ? num_fkin / seconds : 0;
+
+    printf("Generation %zu: Time since the last report = %.3f s:", generation, seconds);
+
+    for (size_t i = 0; i < NUM_PHASES; i++) {
+        double phase_seconds = (now.phase_ns[i] - last->phase_ns[i]) / 1e9;
+        double share = seconds > 0 ? phase_seconds / seconds : 0;
+        printf(" %s %.1f%%", PHASE_NAMES[i], 100 * share);
+    }
+
+    printf(", evaluating %.3f thread-seconds\n", (now.evaluation_ns - last->evaluation_ns) / 1e9);
+    printf("Generation %zu: Evaluations = %" PRIu64 " (%.0f/s), fkin = %" PRIu64 " (%.0f/s), rejected before the sweep = %" PRIu64 ", broken during the sweep = %" PRIu64 "\n",
+           generation, num_evaluations, evaluations_per_second, num_fkin, fkin_per_second, num_rejected, num_broken);
+    printf("Generation %zu: Crank steps where sweeps broke, by eighth of the revolution =", generation);
+
+    for (size_t i = 0; i < NUM_BREAKAGE_BINS; i++) {
+        printf(" %" PRIu64, now.breakage_bins[i] - last->breakage_bins[i]);
+    }
+
+    printf("\n");
+
+    write_counters(t, &now, generation);
+    t->reported = now;
+}
+
+void telemetry_flush(telemetry *t, size_t generation) {
+    telemetry_totals now = telemetry_get_totals(t);
+    write_counters(t, &now, generation);
+    t->reported = now;
+}
+
+void telemetry_free(telemetry *t) {
+    if (t->trace != NULL) {
+        fprintf(t->trace, "\n]\n");
+        fclose(t->trace);
+    }
+
+    free(t);
+}
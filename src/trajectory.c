@@ -1,3 +1,4 @@
+#include <stdio.h>
 #include <stdlib.h>
 
 #include "utils.h"
@@ -8,4 +9,46 @@ trajectory *trajectory_init(size_t length) {
     check_memory(traj);
     traj->length = length;
     return traj;
-}
\ No newline at end of file
+}
+
+trajectory *trajectory_read(const char *path) {
+    FILE *file = fopen(path, "r");
+
+    if (file == NULL) {
+        fprintf(stderr, "Error: Could not open file %s\n", path);
+        exit(1);
+    }
+
+    // Count the number of lines in the file
+    size_t num_lines = 0;
+    char c;
+
+    while ((c = fgetc(file)) != EOF) {
+        if (c == '\n') {
+            num_lines++;
+        }
+    }
+
+    // Every fitness compares the stride against the target, so it needs at
+    // least one waypoint
+    if (num_lines == 0) {
+        fprintf(stderr, "Error: The trajectory %s has no waypoints\n", path);
+        exit(1);
+    }
+
+    // Allocate memory for the trajectory
+    trajectory *target_stride = trajectory_init(num_lines);
+
+    // Read the waypoints from the file
+    rewind(file);
+
+    for (size_t i = 0; i < num_lines; i++) {
+        waypoint wp;
+        fscanf(file, "%" FORMAT_SPECIFIER " %" FORMAT_SPECIFIER " %" FORMAT_SPECIFIER, &wp.x, &wp.y, &wp.t);
+        target_stride->waypoints[i] = wp;
+    }
+
+    fclose(file);
+
+    return target_stride;
+}